@@ -23,6 +23,11 @@
 
 #include "audio_output.h"
 
+#include <pthread.h>
+
+static struct gkick_audio_output_tables gkick_audio_output_tables;
+static pthread_once_t gkick_audio_output_tables_once = PTHREAD_ONCE_INIT;
+
 enum geonkick_error
 gkick_audio_output_create(struct gkick_audio_output **audio_output)
 {
@@ -36,34 +41,40 @@ gkick_audio_output_create(struct gkick_audio_output **audio_output)
                 gkick_log_error("can't allocate memory");
                 return GEONKICK_ERROR;
         }
-        (*audio_output)->decay   = -1;
         (*audio_output)->play    = false;
+        (*audio_output)->polyphony = GEONKICK_DEFAULT_POLYPHONY;
+        (*audio_output)->voice_stealing = GEONKICK_VOICE_STEALING_OLDEST;
 	(*audio_output)->enabled = true;
         (*audio_output)->channel = 0;
+        pthread_once(&gkick_audio_output_tables_once, gkick_audio_output_init_tables);
 
-        gkick_buffer_new((struct gkick_buffer**)&(*audio_output)->updated_buffer,
-                         GEONKICK_MAX_KICK_BUFFER_SIZE);
-        if ((*audio_output)->updated_buffer == NULL) {
-                gkick_log_error("can't create updated buffer");
+        struct gkick_buffer *buffer = NULL;
+        gkick_buffer_new(&buffer, GEONKICK_MAX_KICK_BUFFER_SIZE);
+        if (buffer == NULL) {
+                gkick_log_error("can't create published buffer");
                 gkick_audio_output_free(audio_output);
                 return GEONKICK_ERROR;
         }
-        gkick_buffer_set_size((struct gkick_buffer*)(*audio_output)->updated_buffer, 0);
+        gkick_buffer_set_size(buffer, 0);
+        atomic_init(&(*audio_output)->published_buffer, (uintptr_t)buffer);
 
-        gkick_buffer_new((struct gkick_buffer**)&(*audio_output)->playing_buffer,
+        gkick_buffer_new(&(*audio_output)->playing_buffer,
                          GEONKICK_MAX_KICK_BUFFER_SIZE);
         if ((*audio_output)->playing_buffer == NULL) {
                 gkick_log_error("can't create playing buffer");
                 gkick_audio_output_free(audio_output);
                 return GEONKICK_ERROR;
         }
-        gkick_buffer_set_size((struct gkick_buffer*)(*audio_output)->playing_buffer, 0);
+        gkick_buffer_set_size((*audio_output)->playing_buffer, 0);
 
-        if (pthread_mutex_init(&(*audio_output)->lock, NULL) != 0) {
-                gkick_log_error("error on init mutex");
+        gkick_buffer_new(&(*audio_output)->spare_buffer,
+                         GEONKICK_MAX_KICK_BUFFER_SIZE);
+        if ((*audio_output)->spare_buffer == NULL) {
+                gkick_log_error("can't create spare buffer");
                 gkick_audio_output_free(audio_output);
                 return GEONKICK_ERROR;
-	}
+        }
+        gkick_buffer_set_size((*audio_output)->spare_buffer, 0);
 
         return GEONKICK_OK;
 }
@@ -71,32 +82,86 @@ gkick_audio_output_create(struct gkick_audio_output **audio_output)
 void gkick_audio_output_free(struct gkick_audio_output **audio_output)
 {
         if (audio_output != NULL && *audio_output != NULL) {
-                struct gkick_buffer *p = (struct gkick_buffer*)((*audio_output)->playing_buffer);
+                uintptr_t published = atomic_load(&(*audio_output)->published_buffer);
+                struct gkick_buffer *p = (struct gkick_buffer*)(published
+                                                                & ~GKICK_AUDIO_OUTPUT_BUFFER_FLAGS);
                 gkick_buffer_free(&p);
-                p = (struct gkick_buffer*)((*audio_output)->updated_buffer);
-                gkick_buffer_free(&p);
-                pthread_mutex_destroy(&(*audio_output)->lock);
+                gkick_buffer_free(&(*audio_output)->playing_buffer);
+                gkick_buffer_free(&(*audio_output)->spare_buffer);
                 free(*audio_output);
                 *audio_output = NULL;
         }
 }
 
+/**
+ * A pressed key starts a new voice, a released key
+ * releases the voices playing the note.
+ */
 enum geonkick_error
 gkick_audio_output_key_pressed(struct gkick_audio_output *audio_output,
                                struct gkick_note_info *key)
 {
         if (key->state == GKICK_KEY_STATE_PRESSED) {
-                audio_output->key = *key;
-                audio_output->is_play = true;
                 gkick_audio_output_swap_buffers(audio_output);
+                struct gkick_voice *voice = gkick_audio_output_get_voice(audio_output);
+                voice->active      = true;
+                voice->buffer      = audio_output->playing_buffer;
+                voice->index       = 0;
+                voice->fraction    = 0;
+                voice->state       = GKICK_KEY_STATE_PRESSED;
+                voice->note        = key->note_number;
+                voice->velocity    = (gkick_real)key->velocity / 127;
+                voice->tune_step   = gkick_audio_output_tune_step(key->note_number);
+                voice->kernel      = gkick_audio_output_resampler_kernel(key->note_number);
+                voice->decay       = GEKICK_KEY_RELESE_DECAY_TIME;
+                voice->order       = audio_output->voices_order++;
+                voice->level       = voice->velocity;
+                audio_output->is_play = true;
         } else {
-                audio_output->decay = GEKICK_KEY_RELESE_DECAY_TIME;
-                audio_output->key.state = key->state;
+                for (size_t i = 0; i < GEONKICK_MAX_POLYPHONY; i++) {
+                        struct gkick_voice *voice = &audio_output->voices[i];
+                        if (voice->active && voice->note == key->note_number
+                            && voice->state != GKICK_KEY_STATE_RELEASED) {
+                                voice->state = GKICK_KEY_STATE_RELEASED;
+                                voice->decay = GEKICK_KEY_RELESE_DECAY_TIME;
+                        }
+                }
         }
 
         return GEONKICK_OK;
 }
 
+/**
+ * Returns a free voice. If all the voices are playing, the
+ * oldest or the quietest voice is taken, depending on the
+ * voice stealing mode.
+ */
+struct gkick_voice*
+gkick_audio_output_get_voice(struct gkick_audio_output *audio_output)
+{
+        size_t polyphony = audio_output->polyphony;
+        if (polyphony < 1 || polyphony > GEONKICK_MAX_POLYPHONY)
+                polyphony = 1;
+
+        struct gkick_voice *voice = &audio_output->voices[0];
+        for (size_t i = 0; i < polyphony; i++) {
+                if (!audio_output->voices[i].active)
+                        return &audio_output->voices[i];
+        }
+
+        bool quietest = audio_output->voice_stealing == GEONKICK_VOICE_STEALING_QUIETEST;
+        for (size_t i = 1; i < polyphony; i++) {
+                struct gkick_voice *v = &audio_output->voices[i];
+                if (quietest && v->level != voice->level) {
+                        if (v->level < voice->level)
+                                voice = v;
+                } else if (v->order < voice->order) {
+                        voice = v;
+                }
+        }
+        return voice;
+}
+
 enum geonkick_error
 gkick_audio_output_play(struct gkick_audio_output *audio_output)
 {
@@ -104,19 +169,130 @@ gkick_audio_output_play(struct gkick_audio_output *audio_output)
         return GEONKICK_OK;
 }
 
-gkick_real
-gkick_audio_output_tune_factor(int note_number)
+/**
+ * Initializes the tables shared by the audio outputs,
+ * called once by the first created audio output.
+ */
+void
+gkick_audio_output_init_tables(void)
 {
-        return exp2f((gkick_real)(note_number - 69) / 12.0f);
+        struct gkick_audio_output_tables *tables = &gkick_audio_output_tables;
+        for (size_t i = 0; i < GKICK_AUDIO_OUTPUT_NOTES; i++)
+                tables->tune_table[i] = exp2(((double)i - 69.0) / 12.0 + 32.0);
+
+        for (size_t band = 0; band < GKICK_AUDIO_OUTPUT_RESAMPLER_BANDS; band++) {
+                double step = exp2((double)(band * GKICK_AUDIO_OUTPUT_RESAMPLER_BAND_NOTES) / 12.0);
+                gkick_audio_output_init_resampler(tables->resampler_kernels[band],
+                                                  GKICK_AUDIO_OUTPUT_RESAMPLER_CUTOFF / step);
+        }
 }
 
-enum geonkick_error
-gkick_audio_output_get_frame(struct gkick_audio_output *audio_output,
-                             gkick_real *val)
+uint64_t
+gkick_audio_output_tune_step(int note_number)
 {
-        int release_time = GEKICK_KEY_RELESE_DECAY_TIME;
-        gkick_real decay_val;
+        if (note_number < 0)
+                note_number = 0;
+        else if (note_number > GKICK_AUDIO_OUTPUT_NOTES - 1)
+                note_number = GKICK_AUDIO_OUTPUT_NOTES - 1;
+        return gkick_audio_output_tables.tune_table[note_number];
+}
 
+/* Returns the resampler kernel of the band of the note. */
+const gkick_real*
+gkick_audio_output_resampler_kernel(int note_number)
+{
+        size_t band = 0;
+        if (note_number > 69) {
+                band = (note_number - 69 + GKICK_AUDIO_OUTPUT_RESAMPLER_BAND_NOTES - 1)
+                        / GKICK_AUDIO_OUTPUT_RESAMPLER_BAND_NOTES;
+                if (band > GKICK_AUDIO_OUTPUT_RESAMPLER_BANDS - 1)
+                        band = GKICK_AUDIO_OUTPUT_RESAMPLER_BANDS - 1;
+        }
+        return gkick_audio_output_tables.resampler_kernels[band];
+}
+
+/**
+ * Fills the polyphase kernel of the resampler with a sinc
+ * windowed by a 4-term Blackman-Harris window. Every phase
+ * is normalized to the unity gain for DC.
+ *
+ * @param cutoff the cutoff relative to the Nyquist frequency.
+ */
+void
+gkick_audio_output_init_resampler(gkick_real *kernel, double cutoff)
+{
+        size_t taps = GKICK_AUDIO_OUTPUT_RESAMPLER_TAPS;
+        for (size_t p = 0; p <= GKICK_AUDIO_OUTPUT_RESAMPLER_PHASES; p++) {
+                double d = (double)p / GKICK_AUDIO_OUTPUT_RESAMPLER_PHASES;
+                gkick_real *row = kernel + p * taps;
+                double sum = 0.0;
+                for (size_t j = 0; j < taps; j++) {
+                        double x = (double)j - (double)(taps / 2 - 1) - d;
+                        double h = cutoff;
+                        if (fabs(x) > 1e-9)
+                                h = sin(M_PI * cutoff * x) / (M_PI * x);
+                        double t = (x + taps / 2) / taps;
+                        double w = 0.35875 - 0.48829 * cos(2.0 * M_PI * t)
+                                + 0.14128 * cos(4.0 * M_PI * t)
+                                - 0.01168 * cos(6.0 * M_PI * t);
+                        row[j] = h * w;
+                        sum += row[j];
+                }
+                for (size_t j = 0; j < taps; j++)
+                        row[j] /= sum;
+        }
+}
+
+/**
+ * Returns the frame at the position index + fraction of the data
+ * interpolated with the polyphase kernel. The kernel phases are
+ * interpolated linearly. The frames outside the data are zeros.
+ */
+gkick_real
+gkick_audio_output_resample(const gkick_real *kernel,
+                            const gkick_real *data,
+                            size_t size,
+                            size_t index,
+                            uint32_t fraction)
+{
+        const size_t taps = GKICK_AUDIO_OUTPUT_RESAMPLER_TAPS;
+        const int shift = 32 - GKICK_AUDIO_OUTPUT_RESAMPLER_PHASE_BITS;
+        uint32_t p = fraction >> shift;
+        gkick_real t = (gkick_real)(fraction & ((1u << shift) - 1)) / (1u << shift);
+        const gkick_real *row0 = kernel + p * taps;
+        const gkick_real *row1 = row0 + taps;
+
+        const gkick_real *frames;
+        gkick_real edge[GKICK_AUDIO_OUTPUT_RESAMPLER_TAPS];
+        if (index < taps / 2 - 1 || index + taps / 2 >= size) {
+                for (size_t j = 0; j < taps; j++) {
+                        size_t k = index + j - (taps / 2 - 1);
+                        edge[j] = (index + j >= taps / 2 - 1 && k < size) ? data[k] : 0.0f;
+                }
+                frames = edge;
+        } else {
+                frames = data + index - (taps / 2 - 1);
+        }
+
+        /**
+         * Eight partial sums, so the compiler can use the
+         * SIMD instructions of the target for the taps.
+         */
+        gkick_real sum[8] = {0.0f};
+        for (size_t j = 0; j < taps; j += 8) {
+                for (size_t k = 0; k < 8; k++) {
+                        gkick_real c = row0[j + k] + t * (row1[j + k] - row0[j + k]);
+                        sum[k] += c * frames[j + k];
+                }
+        }
+        return ((sum[0] + sum[4]) + (sum[1] + sum[5]))
+                + ((sum[2] + sum[6]) + (sum[3] + sum[7]));
+}
+
+/* Starts playing if requested by gkick_audio_output_play. */
+void
+gkick_audio_output_check_play(struct gkick_audio_output *audio_output)
+{
         if (audio_output->play) {
                 struct gkick_note_info key;
                 key.channel     = 1;
@@ -126,79 +302,366 @@ gkick_audio_output_get_frame(struct gkick_audio_output *audio_output,
                 gkick_audio_output_key_pressed(audio_output, &key);
                 audio_output->play = false;
         }
+}
 
-        *val = 0;
-        if (audio_output->is_play) {
-                if (gkick_buffer_is_end((struct gkick_buffer*)audio_output->playing_buffer)) {
-                        audio_output->is_play = false;
-                } else {
-                        struct gkick_buffer *buff = (struct gkick_buffer*)audio_output->playing_buffer;
-                        gkick_real factor = gkick_audio_output_tune_factor(audio_output->key.note_number);
-                        if (audio_output->tune)
-                                *val = gkick_buffer_stretch_get_next(buff, factor);
-                        else
-                                *val = gkick_buffer_get_next(buff);
-
-                        if (gkick_buffer_size(buff) - gkick_buffer_index(buff) == GEKICK_KEY_RELESE_DECAY_TIME) {
-                                audio_output->decay     = GEKICK_KEY_RELESE_DECAY_TIME;
-                                audio_output->key.state = GKICK_KEY_STATE_RELEASED;
-                        }
+/**
+ * Returns the next frame of the voice.
+ *
+ * A voice that didn't start waits while the frames are not committed
+ * by the synthesizer, a started voice that reaches the uncommitted
+ * frames ends. Near the end of the buffer the voice is released,
+ * the release curve is liniear from 1.0 to 0 during
+ * GEKICK_KEY_RELESE_DECAY_TIME frames.
+ */
+gkick_real
+gkick_audio_output_voice_next_frame(struct gkick_voice *voice,
+                                    bool tune)
+{
+        int release_time = GEKICK_KEY_RELESE_DECAY_TIME;
+        struct gkick_buffer *buff = voice->buffer;
+        size_t size = buff->size;
+        if (size < 1 || voice->index > size - 1) {
+                voice->active = false;
+                return 0.0f;
+        }
+
+        /* The tuned voice needs the frames after the position for the resampling. */
+        size_t ahead = tune ? GKICK_AUDIO_OUTPUT_RESAMPLER_TAPS / 2 : 1;
+        size_t committed = atomic_load_explicit(&buff->committed, memory_order_acquire);
+        if (committed < size && voice->index + ahead >= committed) {
+                /**
+                 * The voice waits for the first frames of the percussion being
+                 * synthesized. A started voice ends here, waiting would insert
+                 * silence in the middle of the hit.
+                 */
+                if (voice->index > 0 || voice->fraction > 0)
+                        voice->active = false;
+                return 0.0f;
+        }
 
-                        if (audio_output->key.state == GKICK_KEY_STATE_RELEASED)
-                                decay_val = - 1.0f * ((gkick_real)(release_time - audio_output->decay) / release_time) + 1.0;
-                        else
-                                decay_val = 1.0f;
-                        *val *= decay_val * ((gkick_real)audio_output->key.velocity / 127);
+        gkick_real val;
+        if (tune) {
+                val = gkick_audio_output_resample(voice->kernel, buff->buff, size,
+                                                  voice->index, voice->fraction);
+                uint64_t position = voice->fraction + voice->tune_step;
+                voice->index += position >> 32;
+                voice->fraction = position;
+        } else {
+                val = buff->buff[voice->index++];
+        }
 
-                        if (audio_output->key.state == GKICK_KEY_STATE_RELEASED) {
-                                audio_output->decay--;
-                                if (audio_output->decay < 0)
-                                        audio_output->is_play = false;
+        if (voice->state != GKICK_KEY_STATE_RELEASED
+            && size > (size_t)release_time
+            && voice->index + release_time >= size) {
+                voice->decay = release_time;
+                voice->state = GKICK_KEY_STATE_RELEASED;
+        }
+
+        gkick_real decay_val = 1.0f;
+        if (voice->state == GKICK_KEY_STATE_RELEASED)
+                decay_val = - 1.0f * ((gkick_real)(release_time - voice->decay) / release_time) + 1.0;
+        val *= decay_val * voice->velocity;
+
+        if (voice->state == GKICK_KEY_STATE_RELEASED) {
+                voice->decay--;
+                if (voice->decay < 0)
+                        voice->active = false;
+        }
+        return val;
+}
+
+/**
+ * Adds a block of the voice frames to the out buffer
+ * and returns the peak level of the voice in the block.
+ *
+ * While the voice is not released, the committed frames are added
+ * in one loop without the per frame checks. The loop of the not
+ * tuned voice can be vectorized.
+ */
+gkick_real
+gkick_audio_output_voice_render(struct gkick_voice *voice,
+                                bool tune,
+                                gkick_real *out,
+                                size_t size)
+{
+        size_t release_time = GEKICK_KEY_RELESE_DECAY_TIME;
+        struct gkick_buffer *buff = voice->buffer;
+        gkick_real level = 0.0f;
+        size_t i = 0;
+        while (i < size && voice->active) {
+                if (voice->state != GKICK_KEY_STATE_RELEASED) {
+                        size_t buffer_size = buff->size;
+                        size_t ahead = tune ? GKICK_AUDIO_OUTPUT_RESAMPLER_TAPS / 2 : 1;
+                        size_t committed = atomic_load_explicit(&buff->committed,
+                                                                memory_order_acquire);
+                        size_t end = buffer_size;
+                        if (committed < buffer_size)
+                                end = committed > ahead ? committed - ahead : 0;
+                        if (buffer_size > release_time && end > buffer_size - release_time)
+                                end = buffer_size - release_time;
+
+                        size_t n = 0;
+                        gkick_real velocity = voice->velocity;
+                        if (tune) {
+                                const gkick_real *data = buff->buff;
+                                const gkick_real *kernel = voice->kernel;
+                                uint64_t tune_step = voice->tune_step;
+                                size_t index = voice->index;
+                                uint32_t fraction = voice->fraction;
+                                while (i < size && index < end) {
+                                        gkick_real v = velocity
+                                                * gkick_audio_output_resample(kernel,
+                                                                              data,
+                                                                              buffer_size,
+                                                                              index,
+                                                                              fraction);
+                                        out[i++] += v;
+                                        if (v < 0.0f)
+                                                v = -v;
+                                        if (v > level)
+                                                level = v;
+                                        uint64_t position = fraction + tune_step;
+                                        index += position >> 32;
+                                        fraction = position;
+                                        n++;
+                                }
+                                voice->index = index;
+                                voice->fraction = fraction;
+                        } else {
+                                n = end > voice->index ? end - voice->index : 0;
+                                if (n > size - i)
+                                        n = size - i;
+                                const gkick_real *src = buff->buff + voice->index;
+                                gkick_real *dst = out + i;
+                                for (size_t j = 0; j < n; j++)
+                                        dst[j] += src[j] * velocity;
+                                /* The level for the voice stealing is estimated sparsely. */
+                                for (size_t j = 0; j < n; j += 16) {
+                                        gkick_real v = src[j] < 0.0f ? -src[j] : src[j];
+                                        if (v * velocity > level)
+                                                level = v * velocity;
+                                }
+                                voice->index += n;
+                                i += n;
+                        }
+
+                        if (n > 0) {
+                                if (buffer_size > release_time
+                                    && voice->index + release_time >= buffer_size) {
+                                        voice->state = GKICK_KEY_STATE_RELEASED;
+                                        voice->decay = release_time - 1;
+                                }
+                                continue;
                         }
                 }
+
+                gkick_real v = gkick_audio_output_voice_next_frame(voice, tune);
+                out[i++] += v;
+                if (v < 0.0f)
+                        v = -v;
+                if (v > level)
+                        level = v;
         }
 
-        *val *= (gkick_real)audio_output->limiter / 1000000;
+        voice->level = level;
+        return level;
+}
 
-        return GEONKICK_OK;
+/**
+ * Returns the sum of the next frames of the voices
+ * without the limiter applied.
+ */
+gkick_real
+gkick_audio_output_next_frame(struct gkick_audio_output *audio_output)
+{
+        gkick_real val = 0.0f;
+        if (!audio_output->is_play)
+                return val;
+
+        bool tune = audio_output->tune;
+        bool is_play = false;
+        for (size_t i = 0; i < GEONKICK_MAX_POLYPHONY; i++) {
+                struct gkick_voice *voice = &audio_output->voices[i];
+                if (voice->active) {
+                        val += gkick_audio_output_voice_next_frame(voice, tune);
+                        is_play = is_play || voice->active;
+                }
+        }
+        audio_output->is_play = is_play;
+        return val;
 }
 
-void gkick_audio_output_lock(struct gkick_audio_output *audio_output)
+enum geonkick_error
+gkick_audio_output_get_frame(struct gkick_audio_output *audio_output,
+                             gkick_real *val)
 {
-        if (audio_output != NULL)
-                pthread_mutex_lock(&audio_output->lock);
+        gkick_audio_output_check_play(audio_output);
+        *val = gkick_audio_output_next_frame(audio_output);
+        *val *= (gkick_real)audio_output->limiter / 1000000;
+        return GEONKICK_OK;
 }
 
-void gkick_audio_output_unlock(struct gkick_audio_output *audio_output)
+/**
+ * Renders a block of frames of the output into the out buffer.
+ * The outputs that are not playing are only filled with zeros.
+ */
+void
+gkick_audio_output_render(struct gkick_audio_output *audio_output,
+                          gkick_real *out,
+                          size_t size)
 {
-        if (audio_output != NULL)
-                pthread_mutex_unlock(&audio_output->lock);
+        gkick_audio_output_check_play(audio_output);
+        memset(out, 0, size * sizeof(gkick_real));
+        if (!audio_output->is_play)
+                return;
+
+        bool tune = audio_output->tune;
+        bool is_play = false;
+        for (size_t i = 0; i < GEONKICK_MAX_POLYPHONY; i++) {
+                struct gkick_voice *voice = &audio_output->voices[i];
+                if (voice->active) {
+                        gkick_audio_output_voice_render(voice,
+                                                        tune,
+                                                        out,
+                                                        size);
+                        is_play = is_play || voice->active;
+                }
+        }
+        audio_output->is_play = is_play;
+
+        gkick_real limiter = (gkick_real)audio_output->limiter / 1000000;
+        for (size_t i = 0; i < size; i++)
+                out[i] *= limiter;
 }
 
 struct gkick_buffer*
 gkick_audio_output_get_buffer(struct gkick_audio_output  *audio_output)
 {
-        return (struct gkick_buffer*)audio_output->playing_buffer;
+        return audio_output->playing_buffer;
+}
+
+/**
+ * Publishes the buffer of the synthesizer and returns the buffer
+ * the synthesizer can use for the next synthesis. The returned buffer
+ * is either the previous published buffer that was not taken, or
+ * a buffer given back by the audio thread that is not played.
+ * Called only by the synthesizer.
+ */
+struct gkick_buffer*
+gkick_audio_output_publish_buffer(struct gkick_audio_output *audio_output,
+                                  struct gkick_buffer *buffer)
+{
+        uintptr_t published = atomic_exchange_explicit(&audio_output->published_buffer,
+                                                       (uintptr_t)buffer
+                                                       | GKICK_AUDIO_OUTPUT_BUFFER_FRESH,
+                                                       memory_order_acq_rel);
+        audio_output->replaced_buffer = published;
+        return (struct gkick_buffer*)(published & ~GKICK_AUDIO_OUTPUT_BUFFER_FLAGS);
+}
+
+/**
+ * Takes back the buffer of a cancelled synthesis and publishes again
+ * the buffer it replaced, so the last complete percussion keeps playing.
+ * Fails if the audio thread already took the buffer. On success the
+ * buffer is owned again by the synthesizer.
+ * Called only by the synthesizer.
+ */
+bool
+gkick_audio_output_retract_buffer(struct gkick_audio_output *audio_output,
+                                  struct gkick_buffer *buffer)
+{
+        uintptr_t expected = (uintptr_t)buffer | GKICK_AUDIO_OUTPUT_BUFFER_FRESH;
+        return atomic_compare_exchange_strong_explicit(&audio_output->published_buffer,
+                                                       &expected,
+                                                       audio_output->replaced_buffer,
+                                                       memory_order_acq_rel,
+                                                       memory_order_acquire);
+}
+
+/**
+ * Tags the published buffer as complete when its synthesis is done.
+ * Nothing is done if the audio thread already took the buffer.
+ * Called only by the synthesizer.
+ */
+void
+gkick_audio_output_complete_buffer(struct gkick_audio_output *audio_output,
+                                   struct gkick_buffer *buffer)
+{
+        uintptr_t expected = (uintptr_t)buffer | GKICK_AUDIO_OUTPUT_BUFFER_FRESH;
+        atomic_compare_exchange_strong_explicit(&audio_output->published_buffer,
+                                                &expected,
+                                                expected | GKICK_AUDIO_OUTPUT_BUFFER_COMPLETE,
+                                                memory_order_release,
+                                                memory_order_relaxed);
+}
+
+bool
+gkick_audio_output_is_buffer_played(struct gkick_audio_output *audio_output,
+                                    struct gkick_buffer *buffer)
+{
+        for (size_t i = 0; i < GEONKICK_MAX_POLYPHONY; i++) {
+                if (audio_output->voices[i].active
+                    && audio_output->voices[i].buffer == buffer)
+                        return true;
+        }
+        return false;
+}
+
+void
+gkick_audio_output_stop_buffer(struct gkick_audio_output *audio_output,
+                               struct gkick_buffer *buffer)
+{
+        for (size_t i = 0; i < GEONKICK_MAX_POLYPHONY; i++) {
+                if (audio_output->voices[i].buffer == buffer)
+                        audio_output->voices[i].active = false;
+        }
 }
 
+/**
+ * Takes the latest published buffer for the new voices, without locks.
+ * While the published buffer is being synthesized, the new voices keep
+ * playing the last complete percussion. A buffer being synthesized is
+ * taken only if there is no complete percussion to play.
+ *
+ * The audio thread gives back the playing buffer if it is not played
+ * anymore, otherwise it keeps it as the spare buffer and gives back
+ * the previous spare buffer. Only when the voices of both buffers still
+ * play (three hits of three different syntheses are overlapping),
+ * the voices of the spare buffer are stopped like stolen voices.
+ * Called only by the audio thread.
+ */
 void gkick_audio_output_swap_buffers(struct gkick_audio_output *audio_output)
 {
-        gkick_buffer_reset((struct gkick_buffer*)audio_output->playing_buffer);
+        uintptr_t published = atomic_load_explicit(&audio_output->published_buffer,
+                                                   memory_order_acquire);
+        struct gkick_buffer *playing = audio_output->playing_buffer;
+        bool has_complete = playing->size > 0
+                && atomic_load_explicit(&playing->committed, memory_order_acquire) >= playing->size;
+        bool played = gkick_audio_output_is_buffer_played(audio_output, playing);
+        struct gkick_buffer *released = played ? audio_output->spare_buffer : playing;
 
         /**
-         * Try lock. If succesfull, swap buffers. If not, continue with
-         * the current one to play until the next press of the key.
+         * The synthesizer can publish a new buffer or retract
+         * the published one meanwhile, the check is repeated then.
          */
-        if (pthread_mutex_trylock(&audio_output->lock) == 0) {
-                /* Test if the updated buffer is full. Otherwise it means that it was not updated. */
-                if (gkick_buffer_size((struct gkick_buffer*)audio_output->updated_buffer) > 0
-                    && gkick_buffer_is_end((struct gkick_buffer*)audio_output->updated_buffer)) {
-                                        char *buff = audio_output->updated_buffer;
-                                        audio_output->updated_buffer = audio_output->playing_buffer;
-                                        audio_output->playing_buffer = buff;
+        while (published & GKICK_AUDIO_OUTPUT_BUFFER_FRESH) {
+                struct gkick_buffer *buffer = (struct gkick_buffer*)(published
+                                                                     & ~GKICK_AUDIO_OUTPUT_BUFFER_FLAGS);
+                if (has_complete && !(published & GKICK_AUDIO_OUTPUT_BUFFER_COMPLETE))
+                        return;
+
+                if (atomic_compare_exchange_weak_explicit(&audio_output->published_buffer,
+                                                          &published,
+                                                          (uintptr_t)released,
+                                                          memory_order_acq_rel,
+                                                          memory_order_acquire)) {
+                        if (played) {
+                                gkick_audio_output_stop_buffer(audio_output, released);
+                                audio_output->spare_buffer = playing;
+                        }
+                        audio_output->playing_buffer = buffer;
+                        return;
                 }
-                gkick_buffer_reset((struct gkick_buffer*)audio_output->playing_buffer);
-                gkick_audio_output_unlock(audio_output);
         }
 }
 
@@ -244,3 +707,44 @@ gkick_audio_output_get_channel(struct gkick_audio_output *audio_output,
         *channel = audio_output->channel;
         return GEONKICK_OK;
 }
+
+enum geonkick_error
+gkick_audio_output_set_polyphony(struct gkick_audio_output *audio_output,
+                                 size_t polyphony)
+{
+        if (polyphony < 1 || polyphony > GEONKICK_MAX_POLYPHONY) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+        audio_output->polyphony = polyphony;
+        return GEONKICK_OK;
+}
+
+enum geonkick_error
+gkick_audio_output_get_polyphony(struct gkick_audio_output *audio_output,
+                                 size_t *polyphony)
+{
+        *polyphony = audio_output->polyphony;
+        return GEONKICK_OK;
+}
+
+enum geonkick_error
+gkick_audio_output_set_voice_stealing(struct gkick_audio_output *audio_output,
+                                      enum geonkick_voice_stealing stealing)
+{
+        if (stealing != GEONKICK_VOICE_STEALING_OLDEST
+            && stealing != GEONKICK_VOICE_STEALING_QUIETEST) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+        audio_output->voice_stealing = stealing;
+        return GEONKICK_OK;
+}
+
+enum geonkick_error
+gkick_audio_output_get_voice_stealing(struct gkick_audio_output *audio_output,
+                                      enum geonkick_voice_stealing *stealing)
+{
+        *stealing = audio_output->voice_stealing;
+        return GEONKICK_OK;
+}
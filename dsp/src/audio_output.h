@@ -39,6 +39,75 @@
 /* Decay time measured in number of audio frames. */
 #define GEKICK_KEY_RELESE_DECAY_TIME 1000
 
+/**
+ * Flag of the published buffer that is set while the buffer
+ * was not taken yet by the audio thread. The buffers are
+ * allocated with malloc, so the lowest bits of the address are free.
+ */
+#define GKICK_AUDIO_OUTPUT_BUFFER_FRESH ((uintptr_t)1)
+
+/* Flag of the published buffer that is set when the synthesis is done. */
+#define GKICK_AUDIO_OUTPUT_BUFFER_COMPLETE ((uintptr_t)2)
+
+#define GKICK_AUDIO_OUTPUT_BUFFER_FLAGS (GKICK_AUDIO_OUTPUT_BUFFER_FRESH \
+                                         | GKICK_AUDIO_OUTPUT_BUFFER_COMPLETE)
+
+/* Number of the MIDI notes of the tune table. */
+#define GKICK_AUDIO_OUTPUT_NOTES 128
+
+/**
+ * Number of the taps of the resampler kernel of the tuned voices.
+ * The frame at the position is interpolated from the frames
+ * index - TAPS / 2 + 1 to index + TAPS / 2.
+ */
+#define GKICK_AUDIO_OUTPUT_RESAMPLER_TAPS 16
+
+/**
+ * Number of the phases (fractional positions) of the resampler kernel.
+ * The phase is taken from the highest bits of the fraction of the position.
+ */
+#define GKICK_AUDIO_OUTPUT_RESAMPLER_PHASE_BITS 7
+#define GKICK_AUDIO_OUTPUT_RESAMPLER_PHASES (1 << GKICK_AUDIO_OUTPUT_RESAMPLER_PHASE_BITS)
+
+/* Cutoff of the resampler kernel relative to the Nyquist frequency. */
+#define GKICK_AUDIO_OUTPUT_RESAMPLER_CUTOFF 0.9
+
+/**
+ * The notes above A4 play faster than the synthesized buffer, the cutoff
+ * of their kernel is lowered by the step to avoid aliasing. The notes
+ * are grouped in bands of BAND_NOTES semitones, the kernel of a band
+ * has the cutoff for the highest step of the band. The band 0 is for
+ * the notes up to A4.
+ */
+#define GKICK_AUDIO_OUTPUT_RESAMPLER_BAND_NOTES 6
+#define GKICK_AUDIO_OUTPUT_RESAMPLER_BANDS (1 + (GKICK_AUDIO_OUTPUT_NOTES - 69 \
+                                            + GKICK_AUDIO_OUTPUT_RESAMPLER_BAND_NOTES - 2) \
+                                       / GKICK_AUDIO_OUTPUT_RESAMPLER_BAND_NOTES)
+
+/* Size of a resampler kernel, a row of taps for every phase and the phase 1.0. */
+#define GKICK_AUDIO_OUTPUT_RESAMPLER_KERNEL_SIZE ((GKICK_AUDIO_OUTPUT_RESAMPLER_PHASES + 1) \
+                                                  * GKICK_AUDIO_OUTPUT_RESAMPLER_TAPS)
+
+/**
+ * Tables of the tuned voices shared by all audio outputs,
+ * initialized once and only read after.
+ */
+struct gkick_audio_output_tables {
+        /**
+         * Steps of the position of the tuned voices for every note
+         * in units of 2^-32 frames. The note A4 has the step 1.0.
+         */
+        uint64_t tune_table[GKICK_AUDIO_OUTPUT_NOTES];
+
+        /**
+         * Windowed-sinc kernels of the tuned voices for every band.
+         * The last row of a kernel is the phase 1.0, used only
+         * for the interpolation between the phases.
+         */
+        gkick_real resampler_kernels[GKICK_AUDIO_OUTPUT_RESAMPLER_BANDS]
+                                    [GKICK_AUDIO_OUTPUT_RESAMPLER_KERNEL_SIZE];
+};
+
 struct gkick_note_info {
         enum gkick_key_state state;
         char channel;
@@ -46,25 +115,95 @@ struct gkick_note_info {
         char velocity;
 };
 
+/**
+ * A voice plays one hit of the percussion
+ * with its own position in the buffer.
+ * Voices are used only by the audio thread.
+ */
+struct gkick_voice {
+        bool active;
+        struct gkick_buffer *buffer;
+        size_t index;
+        /**
+         * Fractional part of the position of the tuned voice
+         * in units of 2^-32 frames.
+         */
+        uint32_t fraction;
+        enum gkick_key_state state;
+        char note;
+        gkick_real velocity;
+        /* Step of the position per frame in units of 2^-32 frames. */
+        uint64_t tune_step;
+
+        /* Resampler kernel for the step of the tuned voice. */
+        const gkick_real *kernel;
+
+        /* Release time left measured in number of audio frames. */
+        int decay;
+
+        /* Start order of the voice, used to find the oldest voice. */
+        uint64_t order;
+
+        /* Peak level of the last rendered block. */
+        gkick_real level;
+};
+
 struct gkick_audio_output
 {
 	/* Specifies if this audio output is active. */
         _Atomic bool enabled;
 
-        // On this buffer the synthesizer is copying.
-        char* _Atomic updated_buffer;
-        char* _Atomic playing_buffer;
-        _Atomic bool buffer_updated;
+        /**
+         * The buffers are handed between the synthesizer and the
+         * audio thread without locks, like a triple buffer:
+         * the synthesizer owns its buffer, the audio thread owns
+         * the playing and the spare buffer, and the published buffer
+         * is exchanged atomically between them.
+         *
+         * The published buffer is the address of the latest buffer of
+         * the synthesizer tagged with GKICK_AUDIO_OUTPUT_BUFFER_FRESH
+         * until the audio thread takes it. The buffer is published
+         * before the synthesis and filled progressively, only
+         * the committed frames of the buffer can be played.
+         * When the synthesis is done the buffer is tagged also with
+         * GKICK_AUDIO_OUTPUT_BUFFER_COMPLETE, the audio thread doesn't
+         * read the buffer before taking it.
+         */
+        atomic_uintptr_t published_buffer;
 
-        /* Note info is changed only by the audio thread. */
-        struct gkick_note_info key;
+        /**
+         * The published buffer replaced by the last publishing,
+         * used only by the synthesizer to retract the buffer
+         * of a cancelled synthesis.
+         */
+        uintptr_t replaced_buffer;
+
+        /* The buffer played by the new voices, used only by the audio thread. */
+        struct gkick_buffer *playing_buffer;
+
+        /**
+         * The previous playing buffer that can be still played by the
+         * voices, used only by the audio thread. The audio thread gives
+         * back to the synthesizer only a buffer that is not played.
+         */
+        struct gkick_buffer *spare_buffer;
+
+        /* Preallocated voices, used only by the audio thread. */
+        struct gkick_voice voices[GEONKICK_MAX_POLYPHONY];
+        uint64_t voices_order;
+
+        /* Number of the voices that can play at the same time. */
+        atomic_size_t polyphony;
+
+        /* Voice stealing mode, enum geonkick_voice_stealing. */
+        atomic_int voice_stealing;
 
         /* The key number that triggres playing. */
         _Atomic char playing_key;
 
         /**
-         * Specifies if the audio output is in the
-         * playing state (the percussion is playing)
+         * Specifies if the audio output is in the playing
+         * state (at least one voice is playing)
          */
         _Atomic bool is_play;
 
@@ -80,21 +219,11 @@ struct gkick_audio_output
          */
         _Atomic bool tune;
 
-        /**
-         * decay - note release time measured in number of audio frames.
-         * Relaxation curve for audio is liniear:
-         *   - 1.0 * (GEKICK_NOTE_RELEASE_TIME - decay) / GEKICK_NOTE_RELEASE_TIME + 1.0,
-         *    decay from GEKICK_NOTE_RELEASE_TIME to 0;
-         */
-        _Atomic int decay;
-
         /* Output channel. */
       	atomic_size_t channel;
 
         /* Output audio limiter value. */
         atomic_int limiter;
-
-        pthread_mutex_t lock;
 };
 
 enum geonkick_error
@@ -112,16 +241,72 @@ gkick_audio_output_key_pressed(struct gkick_audio_output *audio_output,
 enum geonkick_error
 gkick_audio_output_play(struct gkick_audio_output *audio_output);
 
+void
+gkick_audio_output_init_tables(void);
+
+uint64_t
+gkick_audio_output_tune_step(int note_number);
+
+const gkick_real*
+gkick_audio_output_resampler_kernel(int note_number);
+
+void
+gkick_audio_output_init_resampler(gkick_real *kernel, double cutoff);
+
+gkick_real
+gkick_audio_output_resample(const gkick_real *kernel,
+                            const gkick_real *data,
+                            size_t size,
+                            size_t index,
+                            uint32_t fraction);
+
+void
+gkick_audio_output_check_play(struct gkick_audio_output *audio_output);
+
+struct gkick_voice*
+gkick_audio_output_get_voice(struct gkick_audio_output *audio_output);
+
+gkick_real
+gkick_audio_output_voice_next_frame(struct gkick_voice *voice,
+                                    bool tune);
+
+gkick_real
+gkick_audio_output_voice_render(struct gkick_voice *voice,
+                                bool tune,
+                                gkick_real *out,
+                                size_t size);
+
 gkick_real
-gkick_audio_output_tune_factor(int note_number);
+gkick_audio_output_next_frame(struct gkick_audio_output *audio_output);
 
 enum geonkick_error
 gkick_audio_output_get_frame(struct gkick_audio_output *audio_output,
                              gkick_real *val);
 
-void gkick_audio_output_lock(struct gkick_audio_output *audio_output);
+void
+gkick_audio_output_render(struct gkick_audio_output *audio_output,
+                          gkick_real *out,
+                          size_t size);
+
+struct gkick_buffer*
+gkick_audio_output_publish_buffer(struct gkick_audio_output *audio_output,
+                                  struct gkick_buffer *buffer);
+
+bool
+gkick_audio_output_retract_buffer(struct gkick_audio_output *audio_output,
+                                  struct gkick_buffer *buffer);
+
+void
+gkick_audio_output_complete_buffer(struct gkick_audio_output *audio_output,
+                                   struct gkick_buffer *buffer);
 
-void gkick_audio_output_unlock(struct gkick_audio_output *audio_output);
+bool
+gkick_audio_output_is_buffer_played(struct gkick_audio_output *audio_output,
+                                    struct gkick_buffer *buffer);
+
+void
+gkick_audio_output_stop_buffer(struct gkick_audio_output *audio_output,
+                               struct gkick_buffer *buffer);
 
 void gkick_audio_output_swap_buffers(struct gkick_audio_output *audio_output);
 
@@ -143,4 +328,20 @@ enum geonkick_error
 gkick_audio_output_get_channel(struct gkick_audio_output *audio_output,
                                size_t *channel);
 
+enum geonkick_error
+gkick_audio_output_set_polyphony(struct gkick_audio_output *audio_output,
+                                 size_t polyphony);
+
+enum geonkick_error
+gkick_audio_output_get_polyphony(struct gkick_audio_output *audio_output,
+                                 size_t *polyphony);
+
+enum geonkick_error
+gkick_audio_output_set_voice_stealing(struct gkick_audio_output *audio_output,
+                                      enum geonkick_voice_stealing stealing);
+
+enum geonkick_error
+gkick_audio_output_get_voice_stealing(struct gkick_audio_output *audio_output,
+                                      enum geonkick_voice_stealing *stealing);
+
 #endif // GKICK_AUDO_OUTPUT_H
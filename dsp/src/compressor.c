@@ -23,6 +23,9 @@
 
 #include "compressor.h"
 
+/* Use the math functions of the gkick_real precision. */
+#include <tgmath.h>
+
 enum geonkick_error
 gkick_compressor_new(struct gkick_compressor **compressor)
 {
@@ -37,8 +40,9 @@ gkick_compressor_new(struct gkick_compressor **compressor)
                 return GEONKICK_ERROR;
         }
 
-        (*compressor)->attack    = 0.01f * GEONKICK_SAMPLE_RATE;
-        (*compressor)->release   = 0.01f * GEONKICK_SAMPLE_RATE;
+        (*compressor)->sample_rate = GEONKICK_DEFAULT_SAMPLE_RATE;
+        (*compressor)->attack    = 0.01f * (*compressor)->sample_rate;
+        (*compressor)->release   = 0.01f * (*compressor)->sample_rate;
         (*compressor)->threshold = 0.0f;
         (*compressor)->ratio     = 1.0f;
         (*compressor)->knee      = 0.0f;
@@ -49,6 +53,7 @@ gkick_compressor_new(struct gkick_compressor **compressor)
                 gkick_compressor_free(compressor);
                 return GEONKICK_ERROR;
 	}
+        gkick_compressor_publish(*compressor);
 
         return GEONKICK_OK;
 }
@@ -63,6 +68,67 @@ gkick_compressor_free(struct gkick_compressor **compressor)
         }
 }
 
+/**
+ * Copies the compressor parameters.
+ * The compressor state of the destination is not changed.
+ */
+enum geonkick_error
+gkick_compressor_copy(struct gkick_compressor *dst,
+                      struct gkick_compressor *src)
+{
+        if (dst == NULL || src == NULL) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+
+        gkick_compressor_lock(src);
+        atomic_store(&dst->enabled, atomic_load(&src->enabled));
+        dst->attack    = src->attack;
+        dst->release   = src->release;
+        dst->threshold = src->threshold;
+        dst->ratio     = src->ratio;
+        dst->knee      = src->knee;
+        dst->makeup    = src->makeup;
+        dst->sample_rate = src->sample_rate;
+        gkick_compressor_unlock(src);
+
+        gkick_compressor_lock(dst);
+        gkick_compressor_publish(dst);
+        gkick_compressor_unlock(dst);
+
+        return GEONKICK_OK;
+}
+
+/**
+ * Sets the sample rate and converts the attack
+ * and release times to the new sample rate.
+ */
+enum geonkick_error
+gkick_compressor_set_sample_rate(struct gkick_compressor *compressor,
+                                 gkick_real rate)
+{
+        if (compressor == NULL || rate < 1.0f) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+
+        gkick_compressor_lock(compressor);
+        compressor->attack  = (gkick_real)compressor->attack * rate / compressor->sample_rate;
+        compressor->release = (gkick_real)compressor->release * rate / compressor->sample_rate;
+        compressor->sample_rate = rate;
+        gkick_compressor_publish(compressor);
+        gkick_compressor_unlock(compressor);
+
+        return GEONKICK_OK;
+}
+
+/* Resets the compressor state before the synthesis. */
+void
+gkick_compressor_init(struct gkick_compressor *compressor)
+{
+        compressor->gain = 0.0f;
+}
+
 void
 gkick_compressor_lock(struct gkick_compressor *compressor)
 {
@@ -75,13 +141,52 @@ gkick_compressor_unlock(struct gkick_compressor *compressor)
         pthread_mutex_unlock(&compressor->lock);
 }
 
+/**
+ * Publishes the parameters for the compression.
+ * Must be called with the compressor lock held.
+ */
+void
+gkick_compressor_publish(struct gkick_compressor *compressor)
+{
+        unsigned int seq = atomic_load_explicit(&compressor->params_seq, memory_order_relaxed);
+        atomic_store_explicit(&compressor->params_seq, seq + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        atomic_store_explicit(&compressor->params_attack, compressor->attack, memory_order_relaxed);
+        atomic_store_explicit(&compressor->params_release, compressor->release, memory_order_relaxed);
+        atomic_store_explicit(&compressor->params_threshold, compressor->threshold, memory_order_relaxed);
+        atomic_store_explicit(&compressor->params_ratio, compressor->ratio, memory_order_relaxed);
+        atomic_store_explicit(&compressor->params_knee, compressor->knee, memory_order_relaxed);
+        atomic_store_explicit(&compressor->params_makeup, compressor->makeup, memory_order_relaxed);
+        atomic_store_explicit(&compressor->params_seq, seq + 2, memory_order_release);
+}
+
+/**
+ * Reads the published compressor parameters without the lock.
+ * Retries while the parameters are being updated.
+ */
+void
+gkick_compressor_get_params(struct gkick_compressor *compressor,
+                            struct gkick_compressor_params *params)
+{
+        unsigned int seq;
+        do {
+                seq = atomic_load_explicit(&compressor->params_seq, memory_order_acquire);
+                params->attack    = atomic_load_explicit(&compressor->params_attack, memory_order_relaxed);
+                params->release   = atomic_load_explicit(&compressor->params_release, memory_order_relaxed);
+                params->threshold = atomic_load_explicit(&compressor->params_threshold, memory_order_relaxed);
+                params->ratio     = atomic_load_explicit(&compressor->params_ratio, memory_order_relaxed);
+                params->knee      = atomic_load_explicit(&compressor->params_knee, memory_order_relaxed);
+                params->makeup    = atomic_load_explicit(&compressor->params_makeup, memory_order_relaxed);
+                atomic_thread_fence(memory_order_acquire);
+        } while ((seq & 1)
+                 || seq != atomic_load_explicit(&compressor->params_seq, memory_order_relaxed));
+}
+
 enum geonkick_error
 gkick_compressor_enable(struct gkick_compressor *compressor,
                         int enable)
 {
-        gkick_compressor_lock(compressor);
-        compressor->enabled = enable;
-        gkick_compressor_unlock(compressor);
+        atomic_store(&compressor->enabled, enable);
         return GEONKICK_OK;
 }
 
@@ -89,46 +194,113 @@ enum geonkick_error
 gkick_compressor_is_enabled(struct gkick_compressor *compressor,
                             int *enabled)
 {
-        gkick_compressor_lock(compressor);
-        *enabled = compressor->enabled;
-        gkick_compressor_unlock(compressor);
+        *enabled = atomic_load(&compressor->enabled);
         return GEONKICK_OK;
 }
 
 
+/**
+ * Returns the coefficient of the one pole smoothing filter
+ * for the given attack or release time in frames.
+ */
+gkick_real
+gkick_compressor_time_coefficient(uint64_t frames)
+{
+        if (frames < 1)
+                return 0.0f;
+        return exp(-1.0 / frames);
+}
+
+/**
+ * Computes the static gain reduction for the given level.
+ * The level, threshold and the result are in the log2 domain,
+ * the knee is the width of the soft knee in the same units.
+ *
+ * @return the gain reduction, 0 or negative.
+ */
+gkick_real
+gkick_compressor_gain_computer(gkick_real level,
+                               gkick_real threshold,
+                               gkick_real ratio,
+                               gkick_real knee)
+{
+        gkick_real over = level - threshold;
+        if (knee > 0.0f) {
+                if (2.0f * over < -knee) {
+                        return 0.0f;
+                } else if (2.0f * over <= knee) {
+                        /* Quadratic interpolation inside of the soft knee. */
+                        gkick_real x = over + knee / 2.0f;
+                        return (1.0f / ratio - 1.0f) * x * x / (2.0f * knee);
+                }
+        } else if (over <= 0.0f) {
+                /* Hard knee. */
+                return 0.0f;
+        }
+        return (1.0f / ratio - 1.0f) * over;
+}
+
+/**
+ * Compresses a block of samples, the input and the output can
+ * be the same buffer.
+ *
+ * Feed-forward compressor with the level detection and the gain
+ * smoothing in the log domain. The gain reduction follows the
+ * attack time while it increases and the release time while
+ * it decreases. The parameters are read without the lock,
+ * the compression state must be used only by one thread.
+ */
 enum geonkick_error
-gkick_compressor_val(struct gkick_compressor *compressor,
-                     gkick_real in_val,
-                     gkick_real *out_val)
+gkick_compressor_process(struct gkick_compressor *compressor,
+                         const gkick_real *in,
+                         gkick_real *out,
+                         size_t size)
 {
-        gkick_compressor_lock(compressor);
-        gkick_real threshold = compressor->threshold;
-        if (fabs(compressor->threshold) < DBL_EPSILON || compressor->ratio < 1.0) {
-                gkick_compressor_unlock(compressor);
-                *out_val = compressor->makeup * in_val;
+        if (compressor == NULL || in == NULL || out == NULL) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+
+        struct gkick_compressor_params params;
+        gkick_compressor_get_params(compressor, &params);
+        gkick_real threshold = params.threshold;
+        gkick_real ratio     = params.ratio;
+        gkick_real makeup    = params.makeup;
+        /* Knee width converted from dB to the log2 domain. */
+        gkick_real knee      = params.knee / (20.0 * log10(2.0));
+        gkick_real attack    = gkick_compressor_time_coefficient(params.attack);
+        gkick_real release   = gkick_compressor_time_coefficient(params.release);
+        gkick_real gain      = compressor->gain;
+
+        if (threshold < DBL_EPSILON || ratio <= 1.0f) {
+                for (size_t i = 0; i < size; i++)
+                        out[i] = makeup * in[i];
                 return GEONKICK_OK;
         }
 
-        gkick_real sign = in_val >= 0.0f ? 1.0f : -1.0f;
-        in_val = fabs(in_val);
+        gkick_real threshold_log = log2(threshold);
+        /* Below this level there is no gain reduction. */
+        gkick_real knee_start = threshold * exp2(-knee / 2.0f);
+        for (size_t i = 0; i < size; i++) {
+                gkick_real x = fabs(in[i]);
+                gkick_real reduction = 0.0f;
+                if (x > knee_start)
+                        reduction = gkick_compressor_gain_computer(log2(x),
+                                                                   threshold_log,
+                                                                   ratio,
+                                                                   knee);
 
-        if (in_val > threshold) {
-                gkick_real ratio = compressor->ratio;
-                if (compressor->frames <= compressor->attack && compressor->attack > 0) {
-                        /* Linear increase of the ratio. */
-                        ratio = 1.0 + ((compressor->ratio - 1.0) / compressor->attack) * compressor->frames;
-                        compressor->frames++;
-                }
-                gkick_real diff = (in_val - threshold) / ratio;
-                *out_val = threshold + diff;
-        } else {
-                compressor->frames = 0;
-                *out_val = in_val;
+                gkick_real coefficient = reduction < gain ? attack : release;
+                gain = coefficient * gain + (1.0f - coefficient) * reduction;
+
+                if (gain < -1e-6f)
+                        out[i] = makeup * in[i] * exp2(gain);
+                else
+                        out[i] = makeup * in[i];
         }
 
-        *out_val *= compressor->makeup;
-        gkick_compressor_unlock(compressor);
-        *out_val = sign * (*out_val);
+        compressor->gain = gain;
+
         return GEONKICK_OK;
 }
 
@@ -137,7 +309,8 @@ gkick_compressor_set_attack(struct gkick_compressor *compressor,
                             gkick_real attack)
 {
         gkick_compressor_lock(compressor);
-        compressor->attack = GEONKICK_SAMPLE_RATE * attack;
+        compressor->attack = compressor->sample_rate * attack;
+        gkick_compressor_publish(compressor);
         gkick_compressor_unlock(compressor);
         return GEONKICK_OK;
 }
@@ -147,7 +320,7 @@ gkick_compressor_get_attack(struct gkick_compressor *compressor,
                             gkick_real *attack)
 {
         gkick_compressor_lock(compressor);
-        *attack = (gkick_real)compressor->attack / GEONKICK_SAMPLE_RATE;
+        *attack = (gkick_real)compressor->attack / compressor->sample_rate;
         gkick_compressor_unlock(compressor);
         return GEONKICK_OK;
 }
@@ -157,7 +330,8 @@ gkick_compressor_set_release(struct gkick_compressor *compressor,
                              gkick_real release)
 {
         gkick_compressor_lock(compressor);
-        compressor->release = GEONKICK_SAMPLE_RATE * release;
+        compressor->release = compressor->sample_rate * release;
+        gkick_compressor_publish(compressor);
         gkick_compressor_unlock(compressor);
         return GEONKICK_OK;
 }
@@ -167,7 +341,7 @@ gkick_compressor_get_release(struct gkick_compressor *compressor,
                              gkick_real *release)
 {
         gkick_compressor_lock(compressor);
-        *release = (double)compressor->release / GEONKICK_SAMPLE_RATE;
+        *release = (double)compressor->release / compressor->sample_rate;
         gkick_compressor_unlock(compressor);
         return GEONKICK_OK;
 }
@@ -178,6 +352,7 @@ gkick_compressor_set_threshold(struct gkick_compressor *compressor,
 {
         gkick_compressor_lock(compressor);
         compressor->threshold = threshold;
+        gkick_compressor_publish(compressor);
         gkick_compressor_unlock(compressor);
         return GEONKICK_OK;
 }
@@ -201,6 +376,7 @@ gkick_compressor_set_ratio(struct gkick_compressor *compressor,
                 compressor->ratio = 1.0f;
         else
                 compressor->ratio = ratio;
+        gkick_compressor_publish(compressor);
         gkick_compressor_unlock(compressor);
         return GEONKICK_OK;
 }
@@ -221,6 +397,7 @@ gkick_compressor_set_knee(struct gkick_compressor *compressor,
 {
         gkick_compressor_lock(compressor);
         compressor->knee = knee;
+        gkick_compressor_publish(compressor);
         gkick_compressor_unlock(compressor);
         return GEONKICK_OK;
 }
@@ -241,6 +418,7 @@ gkick_compressor_set_makeup(struct gkick_compressor *compressor,
 {
         gkick_compressor_lock(compressor);
         compressor->makeup = makeup;
+        gkick_compressor_publish(compressor);
         gkick_compressor_unlock(compressor);
         return GEONKICK_OK;
 }
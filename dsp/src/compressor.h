@@ -26,26 +26,55 @@
 
 #include "geonkick_internal.h"
 
+#include <stdatomic.h>
+
+/* A consistent set of the parameters used by the compression. */
+struct gkick_compressor_params {
+        uint64_t attack;
+        uint64_t release;
+        gkick_real threshold;
+        gkick_real ratio;
+        gkick_real knee;
+        gkick_real makeup;
+};
+
 struct gkick_compressor {
-        int enabled;
+        atomic_int enabled;
 
         /* Attack and release time in number of audio frames. */
         uint64_t attack;
         uint64_t release;
 
-        /* Threshold in -dB. */
+        /* Threshold as a linear amplitude, 0 disables the compression. */
         gkick_real threshold;
         /* Ratio from 1.0 to 60. */
         gkick_real ratio;
-        /* Knee in dB. */
+        /* Width of the soft knee in dB. */
         gkick_real knee;
-        /* Makeup in dB. */
+        /* Makeup as a linear gain. */
         gkick_real makeup;
 
-        /* Number of framess elapsed since the start of compression. */
-        uint64_t frames;
-        /* The frame at which the compressor is deactivated. */
-        uint64_t deactivation;
+        /* Sample rate used to convert the attack and release times. */
+        gkick_real sample_rate;
+
+        /**
+         * Smoothed gain reduction in the log2 domain (0 or negative).
+         * The compression state is used only by the synthesis thread.
+         */
+        gkick_real gain;
+
+        /**
+         * Parameters published for the compression. The setters publish
+         * them under a sequence counter that is odd during the update,
+         * so the compression reads a consistent set without the lock.
+         */
+        atomic_uint params_seq;
+        _Atomic uint64_t params_attack;
+        _Atomic uint64_t params_release;
+        _Atomic gkick_real params_threshold;
+        _Atomic gkick_real params_ratio;
+        _Atomic gkick_real params_knee;
+        _Atomic gkick_real params_makeup;
         pthread_mutex_t lock;
 };
 
@@ -55,9 +84,27 @@ gkick_compressor_new(struct gkick_compressor **compressor);
 void
 gkick_compressor_free(struct gkick_compressor **compressor);
 
+void
+gkick_compressor_init(struct gkick_compressor *compressor);
+
+enum geonkick_error
+gkick_compressor_copy(struct gkick_compressor *dst,
+                      struct gkick_compressor *src);
+
+enum geonkick_error
+gkick_compressor_set_sample_rate(struct gkick_compressor *compressor,
+                                 gkick_real rate);
+
 void
 gkick_compressor_lock(struct gkick_compressor *compressor);
 
+void
+gkick_compressor_publish(struct gkick_compressor *compressor);
+
+void
+gkick_compressor_get_params(struct gkick_compressor *compressor,
+                            struct gkick_compressor_params *params);
+
 void
 gkick_compressor_unlock(struct gkick_compressor *compressor);
 
@@ -69,10 +116,20 @@ enum geonkick_error
 gkick_compressor_is_enabled(struct gkick_compressor *compressor,
                             int *enabled);
 
+gkick_real
+gkick_compressor_time_coefficient(uint64_t frames);
+
+gkick_real
+gkick_compressor_gain_computer(gkick_real level,
+                               gkick_real threshold,
+                               gkick_real ratio,
+                               gkick_real knee);
+
 enum geonkick_error
-gkick_compressor_val(struct gkick_compressor *compressor,
-                     gkick_real in_val,
-                     gkick_real *out_val);
+gkick_compressor_process(struct gkick_compressor *compressor,
+                         const gkick_real *in,
+                         gkick_real *out,
+                         size_t size);
 
 enum geonkick_error
 gkick_compressor_set_attack(struct gkick_compressor *compressor,
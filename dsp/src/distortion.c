@@ -39,6 +39,14 @@ gkick_distortion_new(struct gkick_distortion **distortion)
         }
 	(*distortion)->drive_env = NULL;
 	(*distortion)->drive = 1.0f;
+        (*distortion)->oversampling = 1;
+
+        /* The transfer curve is 1 - 10^(-4x) for the input x from 0 to 1.0. */
+        for (size_t i = 0; i <= GKICK_DISTORTION_CURVE_SIZE; i++) {
+                gkick_real x = (gkick_real)i / GKICK_DISTORTION_CURVE_SIZE;
+                (*distortion)->curve[i] = 1.0f - exp(-4.0f * log(10.0f) * x);
+        }
+        gkick_oversampler_init(&(*distortion)->oversampler);
 
 	struct gkick_envelope *env = gkick_envelope_create();
 	if (env == NULL) {
@@ -57,6 +65,7 @@ gkick_distortion_new(struct gkick_distortion **distortion)
                 gkick_distortion_free(distortion);
                 return GEONKICK_ERROR;
 	}
+        gkick_distortion_publish(*distortion);
 
         return GEONKICK_OK;
 }
@@ -73,6 +82,34 @@ gkick_distortion_free(struct gkick_distortion **distortion)
         }
 }
 
+/**
+ * Copies the distortion parameters and the drive envelope.
+ */
+enum geonkick_error
+gkick_distortion_copy(struct gkick_distortion *dst,
+                      struct gkick_distortion *src)
+{
+        if (dst == NULL || src == NULL) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+
+        gkick_distortion_lock(src);
+        atomic_store(&dst->enabled, atomic_load(&src->enabled));
+        dst->in_limiter = src->in_limiter;
+        dst->volume     = src->volume;
+        dst->drive      = src->drive;
+        dst->oversampling = src->oversampling;
+        gkick_envelope_copy(dst->drive_env, src->drive_env);
+        gkick_distortion_unlock(src);
+
+        gkick_distortion_lock(dst);
+        gkick_distortion_publish(dst);
+        gkick_distortion_unlock(dst);
+
+        return GEONKICK_OK;
+}
+
 void gkick_distortion_lock(struct gkick_distortion *distortion)
 {
         pthread_mutex_lock(&distortion->lock);
@@ -83,42 +120,157 @@ void gkick_distortion_unlock(struct gkick_distortion *distortion)
         pthread_mutex_unlock(&distortion->lock);
 }
 
+/**
+ * Publishes the parameters for the distortion.
+ * Must be called with the distortion lock held.
+ */
+void
+gkick_distortion_publish(struct gkick_distortion *distortion)
+{
+        unsigned int seq = atomic_load_explicit(&distortion->params_seq, memory_order_relaxed);
+        atomic_store_explicit(&distortion->params_seq, seq + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        atomic_store_explicit(&distortion->params_in_limiter, distortion->in_limiter, memory_order_relaxed);
+        atomic_store_explicit(&distortion->params_volume, distortion->volume, memory_order_relaxed);
+        atomic_store_explicit(&distortion->params_drive, distortion->drive, memory_order_relaxed);
+        atomic_store_explicit(&distortion->params_oversampling, distortion->oversampling, memory_order_relaxed);
+        atomic_store_explicit(&distortion->params_seq, seq + 2, memory_order_release);
+}
+
+/**
+ * Reads the published distortion parameters without the lock.
+ * Retries while the parameters are being updated.
+ */
+void
+gkick_distortion_get_params(struct gkick_distortion *distortion,
+                            struct gkick_distortion_params *params)
+{
+        unsigned int seq;
+        do {
+                seq = atomic_load_explicit(&distortion->params_seq, memory_order_acquire);
+                params->in_limiter   = atomic_load_explicit(&distortion->params_in_limiter, memory_order_relaxed);
+                params->volume       = atomic_load_explicit(&distortion->params_volume, memory_order_relaxed);
+                params->drive        = atomic_load_explicit(&distortion->params_drive, memory_order_relaxed);
+                params->oversampling = atomic_load_explicit(&distortion->params_oversampling, memory_order_relaxed);
+                atomic_thread_fence(memory_order_acquire);
+        } while ((seq & 1)
+                 || seq != atomic_load_explicit(&distortion->params_seq, memory_order_relaxed));
+}
+
 enum geonkick_error
 gkick_distortion_enable(struct gkick_distortion *distortion, int enable)
 {
-        gkick_distortion_lock(distortion);
-        distortion->enabled = enable;
-        gkick_distortion_unlock(distortion);
+        atomic_store(&distortion->enabled, enable);
         return GEONKICK_OK;
 }
 
 enum geonkick_error
 gkick_distortion_is_enabled(struct gkick_distortion *distortion, int *enabled)
 {
-        gkick_distortion_lock(distortion);
-        *enabled = distortion->enabled;
-        gkick_distortion_unlock(distortion);
+        *enabled = atomic_load(&distortion->enabled);
         return GEONKICK_OK;
 }
 
+/* Resets the oversampling filters before the synthesis. */
+void
+gkick_distortion_init(struct gkick_distortion *distortion)
+{
+        gkick_oversampler_reset(&distortion->oversampler);
+}
+
+/**
+ * Applies the waveshaper in place. The transfer curve is read
+ * from the lookup table with linear interpolation.
+ *
+ * @param drive       values of the drive envelope.
+ * @param drive_shift the drive value of the frame i is drive[i >> drive_shift],
+ *                    used to hold the drive for the oversampled frames.
+ */
+void
+gkick_distortion_shape(const gkick_real *curve,
+                       const struct gkick_distortion_params *params,
+                       gkick_real *data,
+                       size_t size,
+                       const gkick_real *drive,
+                       size_t drive_shift)
+{
+        gkick_real limiter = params->in_limiter;
+        gkick_real amount  = params->drive - 1.0f;
+        gkick_real volume  = params->volume;
+        for (size_t i = 0; i < size; i++) {
+                gkick_real x = limiter * data[i] * (1.0f + amount * drive[i >> drive_shift]);
+                gkick_real ax = x < 0.0f ? -x : x;
+                gkick_real pos = (ax < 1.0f ? ax : 1.0f) * GKICK_DISTORTION_CURVE_SIZE;
+                size_t k = (size_t)pos;
+                if (k > GKICK_DISTORTION_CURVE_SIZE - 1)
+                        k = GKICK_DISTORTION_CURVE_SIZE - 1;
+                gkick_real y = curve[k] + (pos - k) * (curve[k + 1] - curve[k]);
+                data[i] = volume * (x < 0.0f ? -y : y);
+        }
+}
+
+/**
+ * Distorts a block of samples, the input and the output
+ * can be the same buffer.
+ *
+ * With oversampling, the block is upsampled by the half-band stages,
+ * shaped at the higher rate and downsampled back, so the harmonics
+ * generated above the Nyquist frequency are filtered out instead of
+ * being folded back into the audio band. The parameters are read
+ * without the lock, the oversampling state must be used only
+ * by one thread.
+ *
+ * @param drive values of the drive envelope for every sample.
+ */
 enum geonkick_error
-gkick_distortion_val(struct gkick_distortion *distortion,
-                     gkick_real in_val,
-                     gkick_real *out_val,
-		     gkick_real env_x)
+gkick_distortion_process(struct gkick_distortion *distortion,
+                         const gkick_real *in,
+                         gkick_real *out,
+                         size_t size,
+                         const gkick_real *drive)
 {
-        gkick_distortion_lock(distortion);
-	gkick_real x = distortion->in_limiter * in_val;
-	x *= 1.0f + (distortion->drive - 1.0f) * gkick_envelope_get_value(distortion->drive_env, env_x);
+        if (distortion == NULL || in == NULL || out == NULL || drive == NULL) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
 
-        if (x > 1.0f)
-                x = 1.0f;
-        else if (x < -1.0f)
-                x = -1.0f;
+        if (out != in)
+                memcpy(out, in, size * sizeof(gkick_real));
+
+        struct gkick_distortion_params params;
+        gkick_distortion_get_params(distortion, &params);
+        int factor = params.oversampling;
+        if (factor != 2 && factor != 4) {
+                gkick_distortion_shape(distortion->curve, &params, out, size, drive, 0);
+                return GEONKICK_OK;
+        }
+
+        struct gkick_oversampler *oversampler = &distortion->oversampler;
+        const gkick_real *coefficients = oversampler->coefficients;
+        _Alignas(GKICK_SYNTH_BUFFER_ALIGNMENT) gkick_real buffer2x[2 * GKICK_HALFBAND_BLOCK_SIZE];
+        _Alignas(GKICK_SYNTH_BUFFER_ALIGNMENT) gkick_real buffer4x[4 * GKICK_HALFBAND_BLOCK_SIZE];
+        for (size_t start = 0; start < size; start += GKICK_HALFBAND_BLOCK_SIZE) {
+                size_t n = size - start;
+                if (n > GKICK_HALFBAND_BLOCK_SIZE)
+                        n = GKICK_HALFBAND_BLOCK_SIZE;
+
+                gkick_halfband_upsample(coefficients, &oversampler->stages[0],
+                                        out + start, buffer2x, n);
+                if (factor == 4) {
+                        gkick_halfband_upsample(coefficients, &oversampler->stages[1],
+                                                buffer2x, buffer4x, 2 * n);
+                        gkick_distortion_shape(distortion->curve, &params, buffer4x,
+                                               4 * n, drive + start, 2);
+                        gkick_halfband_downsample(coefficients, &oversampler->stages[1],
+                                                  buffer4x, buffer2x, 2 * n);
+                } else {
+                        gkick_distortion_shape(distortion->curve, &params, buffer2x,
+                                               2 * n, drive + start, 1);
+                }
+                gkick_halfband_downsample(coefficients, &oversampler->stages[0],
+                                          buffer2x, out + start, n);
+        }
 
-        *out_val= (x < 0.0f ? -1.0f : 1.0f) * (1.0f - exp(-4.0f * log(10.0f) * fabs(x)));
-        *out_val *= distortion->volume;
-        gkick_distortion_unlock(distortion);
         return GEONKICK_OK;
 }
 
@@ -128,6 +280,7 @@ gkick_distortion_set_volume(struct gkick_distortion *distortion,
 {
         gkick_distortion_lock(distortion);
         distortion->volume = volume;
+        gkick_distortion_publish(distortion);
         gkick_distortion_unlock(distortion);
         return GEONKICK_OK;
 }
@@ -148,6 +301,7 @@ gkick_distortion_set_in_limiter(struct gkick_distortion *distortion,
 {
 	gkick_distortion_lock(distortion);
         distortion->in_limiter = limit;
+        gkick_distortion_publish(distortion);
         gkick_distortion_unlock(distortion);
         return GEONKICK_OK;
 }
@@ -168,6 +322,7 @@ gkick_distortion_set_drive(struct gkick_distortion *distortion,
 {
         gkick_distortion_lock(distortion);
         distortion->drive = drive;
+        gkick_distortion_publish(distortion);
         gkick_distortion_unlock(distortion);
         return GEONKICK_OK;
 }
@@ -181,3 +336,29 @@ gkick_distortion_get_drive(struct gkick_distortion *distortion,
         gkick_distortion_unlock(distortion);
         return GEONKICK_OK;
 }
+
+enum geonkick_error
+gkick_distortion_set_oversampling(struct gkick_distortion *distortion,
+                                  int factor)
+{
+        if (factor != 1 && factor != 2 && factor != 4) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+
+        gkick_distortion_lock(distortion);
+        distortion->oversampling = factor;
+        gkick_distortion_publish(distortion);
+        gkick_distortion_unlock(distortion);
+        return GEONKICK_OK;
+}
+
+enum geonkick_error
+gkick_distortion_get_oversampling(struct gkick_distortion *distortion,
+                                  int *factor)
+{
+        gkick_distortion_lock(distortion);
+        *factor = distortion->oversampling;
+        gkick_distortion_unlock(distortion);
+        return GEONKICK_OK;
+}
@@ -25,14 +25,49 @@
 #define GEONKICK_DISTORTION_H
 
 #include "geonkick_internal.h"
+#include "envelope.h"
+#include "oversampler.h"
+
+#include <stdatomic.h>
+
+/* Number of segments of the transfer curve lookup table. */
+#define GKICK_DISTORTION_CURVE_SIZE 1024
+
+/* A consistent set of the parameters used by the distortion. */
+struct gkick_distortion_params {
+        gkick_real in_limiter;
+        gkick_real volume;
+        gkick_real drive;
+        int oversampling;
+};
 
 struct gkick_distortion {
-        int enabled;
+        atomic_int enabled;
 	/* Input limiter for distortion. */
 	gkick_real in_limiter;
         gkick_real volume;
         gkick_real drive;
 	struct gkick_envelope *drive_env;
+        /* Oversampling factor of the waveshaper: 1, 2 or 4. */
+        int oversampling;
+        /**
+         * Transfer curve of the waveshaper for the input
+         * from 0 to 1.0, interpolated linearly.
+         */
+        gkick_real curve[GKICK_DISTORTION_CURVE_SIZE + 1];
+        /* Used only by the synthesis thread. */
+        struct gkick_oversampler oversampler;
+
+        /**
+         * Parameters published for the distortion. The setters publish
+         * them under a sequence counter that is odd during the update,
+         * so the distortion reads a consistent set without the lock.
+         */
+        atomic_uint params_seq;
+        _Atomic gkick_real params_in_limiter;
+        _Atomic gkick_real params_volume;
+        _Atomic gkick_real params_drive;
+        atomic_int params_oversampling;
         pthread_mutex_t lock;
 };
 
@@ -42,6 +77,10 @@ gkick_distortion_new(struct gkick_distortion **distortion);
 void
 gkick_distortion_free(struct gkick_distortion **distortion);
 
+enum geonkick_error
+gkick_distortion_copy(struct gkick_distortion *dst,
+                      struct gkick_distortion *src);
+
 void gkick_distortion_lock(struct gkick_distortion *distortion);
 
 void gkick_distortion_unlock(struct gkick_distortion *distortion);
@@ -52,11 +91,30 @@ gkick_distortion_enable(struct gkick_distortion *distortion, int enable);
 enum geonkick_error
 gkick_distortion_is_enabled(struct gkick_distortion *distortion, int *enabled);
 
+void
+gkick_distortion_init(struct gkick_distortion *distortion);
+
+void
+gkick_distortion_publish(struct gkick_distortion *distortion);
+
+void
+gkick_distortion_get_params(struct gkick_distortion *distortion,
+                            struct gkick_distortion_params *params);
+
+void
+gkick_distortion_shape(const gkick_real *curve,
+                       const struct gkick_distortion_params *params,
+                       gkick_real *data,
+                       size_t size,
+                       const gkick_real *drive,
+                       size_t drive_shift);
+
 enum geonkick_error
-gkick_distortion_val(struct gkick_distortion *distortion,
-                     gkick_real in_val,
-                     gkick_real *out_val,
-		     gkick_real env_x);
+gkick_distortion_process(struct gkick_distortion *distortion,
+                         const gkick_real *in,
+                         gkick_real *out,
+                         size_t size,
+                         const gkick_real *drive);
 
 enum geonkick_error
 gkick_distortion_set_volume(struct gkick_distortion *distortion,
@@ -82,4 +140,12 @@ enum geonkick_error
 gkick_distortion_get_drive(struct gkick_distortion *distortion,
                            gkick_real *drive);
 
+enum geonkick_error
+gkick_distortion_set_oversampling(struct gkick_distortion *distortion,
+                                  int factor);
+
+enum geonkick_error
+gkick_distortion_get_oversampling(struct gkick_distortion *distortion,
+                                  int *factor);
+
 #endif // GEONKICK_DISTORTION_H
@@ -31,128 +31,194 @@ gkick_envelope_create(void)
 	return envelope;
 }
 
+/**
+ * Evaluates the segment between the points i and i + 1
+ * at the coordinate xm by linear interpolation.
+ */
+gkick_real
+gkick_envelope_segment_value(const struct gkick_envelope *envelope,
+                             size_t i,
+                             gkick_real xm)
+{
+        gkick_real x1 = envelope->x[i];
+        gkick_real x2 = envelope->x[i + 1];
+        gkick_real y1 = envelope->y[i];
+        gkick_real y2 = envelope->y[i + 1];
+	if (x2 - x1 < DBL_EPSILON)
+	        return y1;
+        return (y1 * (x2 - xm) + y2 * (xm - x1)) / (x2 - x1);
+}
+
 gkick_real
 gkick_envelope_get_value(const struct gkick_envelope* envelope, gkick_real xm)
 {
-	gkick_real x1;
-        gkick_real y1 = 0.0f;
-        gkick_real x2;
-        gkick_real y2 = 0.0f;
-        gkick_real ym;
-
-	struct gkick_envelope_point *p;
-	if (envelope == NULL ||
-	    (envelope->first == NULL
-	     || envelope->last == NULL)) {
+	if (envelope == NULL || envelope->npoints == 0)
 		return 0.0f;
-	}
 
-	if (xm < envelope->first->x || xm > envelope->last->x) {
+        size_t n = envelope->npoints;
+	if (xm < envelope->x[0] || xm > envelope->x[n - 1])
 		return 0.0f;
-	} else if (fabsl(xm - envelope->first->x) < DBL_EPSILON) {
-                return envelope->first->y;
-        } else if (fabsl(envelope->last->x - xm) < DBL_EPSILON) {
-                return envelope->last->y;
+        else if (n == 1)
+                return envelope->y[0];
+
+        /* Find the segment containing xm by the binary search. */
+        size_t low = 0;
+        size_t high = n - 1;
+        while (high - low > 1) {
+                size_t mid = low + (high - low) / 2;
+                if (envelope->x[mid] < xm)
+                        low = mid;
+                else
+                        high = mid;
         }
 
-        x2 = x1 = xm;
-	p = envelope->first;
-	while (p) {
-                if (fabs(xm - p->x) < DBL_EPSILON) {
-                        return p->y;
-                } else if (xm < p->x) {
-			x2 = p->x;
-			y2 = p->y;
-			break;
-		}
-		p = p->next;
-	}
-
-	p = envelope->last;
-	while (p) {
-                if (fabs(xm - p->x) < DBL_EPSILON) {
-                        return p->y;
-                } else if (p->x < xm) {
-			x1 = p->x;
-			y1 = p->y;
-			break;
-		}
-		p = p->prev;
-	}
-
-	if (fabsl(x2 - x1) < DBL_EPSILON)
-	        ym = y1;
-	else
-	        ym = (y1 * (x2 - xm) + y2 * (xm - x1)) / (x2 - x1);
-
-	return ym;
+        return gkick_envelope_segment_value(envelope, low, xm);
 }
 
-struct gkick_envelope_point*
-gkick_envelope_add_point(struct gkick_envelope *envelope,
-                         float x,
-                         float y)
+void
+gkick_envelope_cursor_reset(struct gkick_envelope_cursor *cursor)
 {
-	struct gkick_envelope_point *point;
-	if (envelope == NULL)
-		return NULL;
-	point = (struct gkick_envelope_point*)malloc(sizeof(struct gkick_envelope_point));
-	if (point == NULL)
-		return NULL;
-	point->x = x;
-	point->y = y;
-        point->next = point->prev = NULL;
-
-	if (envelope->first == NULL ||  envelope->last == NULL)
-		envelope->first = envelope->last = point;
-	else
-		gkick_envelope_add_sorted(envelope, point);
-	envelope->npoints++;
-	return point;
+        cursor->segment = 0;
+}
+
+/**
+ * Moves the cursor to the segment containing the coordinate xm.
+ *
+ * The coordinate must be inside of the envelope and the envelope
+ * must have at least two points.
+ *
+ * @return the index of the first point of the segment.
+ */
+size_t
+gkick_envelope_cursor_seek(const struct gkick_envelope *envelope,
+                           struct gkick_envelope_cursor *cursor,
+                           gkick_real xm)
+{
+        size_t last = envelope->npoints - 2;
+        size_t i = cursor->segment;
+        if (i > last)
+                i = last;
+        while (i > 0 && xm <= envelope->x[i])
+                i--;
+        while (i < last && xm > envelope->x[i + 1])
+                i++;
+        cursor->segment = i;
+        return i;
+}
+
+gkick_real
+gkick_envelope_cursor_value(const struct gkick_envelope *envelope,
+                            struct gkick_envelope_cursor *cursor,
+                            gkick_real xm)
+{
+	if (envelope == NULL || envelope->npoints == 0)
+		return 0.0f;
+
+        size_t n = envelope->npoints;
+	if (xm < envelope->x[0] || xm > envelope->x[n - 1])
+		return 0.0f;
+        else if (n == 1)
+                return envelope->y[0];
+
+        size_t i = gkick_envelope_cursor_seek(envelope, cursor, xm);
+        return gkick_envelope_segment_value(envelope, i, xm);
 }
 
-void gkick_envelope_add_sorted(struct gkick_envelope *envelope,
-			       struct gkick_envelope_point *point)
+/**
+ * Renders the envelope values for the coordinates (offset + i) * dx,
+ * where i is from 0 to size - 1, into the out buffer.
+ *
+ * Every segment covered by the block is rendered as a linear ramp.
+ */
+void
+gkick_envelope_render(const struct gkick_envelope *envelope,
+                      struct gkick_envelope_cursor *cursor,
+                      size_t offset,
+                      gkick_real dx,
+                      gkick_real *out,
+                      size_t size)
 {
-	struct gkick_envelope_point *p;
-        if (point->x >= envelope->last->x) {
-                /* Add as a last element. */
-		envelope->last->next = point;
-	        point->prev = envelope->last;
-		envelope->last = point;
-	} else if (point->x <= envelope->first->x) {
-                /* Add as a frist element. */
-		envelope->first->prev = point;
-	        point->next = envelope->first;
-		envelope->first = point;
-        } else {
-                p = envelope->first;
-		while (p) {
-                        if (p->next != NULL && point->x < p->next->x) {
-                                p->next->prev = point;
-                                point->next = p->next;
-                                point->prev = p;
-                                p->next = point;
-                                break;
-                        }
-                        p = p->next;
-		}
-	}
+        size_t n = envelope->npoints;
+        size_t i = 0;
+        while (i < size) {
+                gkick_real xm = (gkick_real)(offset + i) * dx;
+                if (n < 2 || dx <= 0.0f
+                    || xm < envelope->x[0] || xm > envelope->x[n - 1]) {
+                        out[i++] = gkick_envelope_get_value(envelope, xm);
+                        continue;
+                }
+
+                size_t k = gkick_envelope_cursor_seek(envelope, cursor, xm);
+                gkick_real x1 = envelope->x[k];
+                gkick_real x2 = envelope->x[k + 1];
+                gkick_real y1 = envelope->y[k];
+                gkick_real y2 = envelope->y[k + 1];
+                if (x2 - x1 < DBL_EPSILON) {
+                        out[i++] = y1;
+                        continue;
+                }
+
+                /* The frames up to the end of the segment. */
+                size_t end = i + 1;
+                while (end < size && (gkick_real)(offset + end) * dx <= x2)
+                        end++;
+
+                gkick_real slope = (y2 - y1) / (x2 - x1);
+                for (size_t j = i; j < end; j++)
+                        out[j] = y1 + slope * ((gkick_real)(offset + j) * dx - x1);
+                i = end;
+        }
+}
+
+/**
+ * Returns the index of the first point with the x coordinate
+ * greater than x, i.e. the position where a point with
+ * this coordinate is inserted after the points with the same x.
+ */
+size_t
+gkick_envelope_upper_bound(const struct gkick_envelope *envelope,
+                           gkick_real x)
+{
+        size_t low = 0;
+        size_t high = envelope->npoints;
+        while (low < high) {
+                size_t mid = low + (high - low) / 2;
+                if (envelope->x[mid] <= x)
+                        low = mid + 1;
+                else
+                        high = mid;
+        }
+        return low;
+}
+
+enum geonkick_error
+gkick_envelope_add_point(struct gkick_envelope *envelope,
+                         gkick_real x,
+                         gkick_real y)
+{
+	if (envelope == NULL)
+		return GEONKICK_ERROR;
+
+        if (envelope->npoints >= GKICK_ENVELOPE_MAX_POINTS) {
+                gkick_log_error("maximum number of envelope points reached");
+                return GEONKICK_ERROR;
+        }
+
+        size_t i = gkick_envelope_upper_bound(envelope, x);
+        size_t n = envelope->npoints - i;
+        memmove(envelope->x + i + 1, envelope->x + i, n * sizeof(gkick_real));
+        memmove(envelope->y + i + 1, envelope->y + i, n * sizeof(gkick_real));
+        envelope->x[i] = x;
+        envelope->y[i] = y;
+	envelope->npoints++;
+	return GEONKICK_OK;
 }
 
 void gkick_envelope_destroy(struct gkick_envelope *envelope)
 {
-	struct gkick_envelope_point *point;
 	if (envelope == NULL)
 		return;
 
-	if (envelope->npoints != 0) {
-		while (envelope->first != NULL) {
-			point = envelope->first;
-			envelope->first = point->next;
-			free(point);
-		}
-	}
 	free(envelope);
 }
 
@@ -161,9 +227,7 @@ gkick_envelope_get_points(struct gkick_envelope *env,
 			  gkick_real **buff,
 			  size_t *npoints)
 {
-        struct gkick_envelope_point *p;
         gkick_real *points;
-        size_t i;
 
         if (buff == NULL)
                 return;
@@ -173,96 +237,91 @@ gkick_envelope_get_points(struct gkick_envelope *env,
                 return;
 
         points = (gkick_real *)calloc(1, sizeof(gkick_real) * (2 * env->npoints));
-        p = env->first;
-        i = 0;
-        while (p) {
-                points[i]     = p->x;
-                points[i + 1] = p->y;
-                p = p->next;
-                i += 2;
+        if (points == NULL)
+                return;
+
+        for (size_t i = 0; i < env->npoints; i++) {
+                points[2 * i]     = env->x[i];
+                points[2 * i + 1] = env->y[i];
         }
 
         *buff = points;
         *npoints = env->npoints;
 }
 
-void
+enum geonkick_error
 gkick_envelope_set_points(struct gkick_envelope *env,
-			  const gkick_real *buff,
-			  size_t npoints)
+                          const gkick_real *buff,
+                          size_t npoints)
 {
         if (env == NULL || buff == NULL)
-                return;
+                return GEONKICK_ERROR;
+
+        /* Reject the points before clearing, the envelope is kept unchanged. */
+        if (npoints > GKICK_ENVELOPE_MAX_POINTS) {
+                gkick_log_error("too many envelope points");
+                return GEONKICK_ERROR;
+        }
 
         gkick_envelope_clear(env);
-        for (size_t i = 0; i < npoints; i++)
-                gkick_envelope_add_point(env, buff[2 * i], buff[2 * i + 1]);
+        for (size_t i = 0; i < npoints; i++) {
+                if (gkick_envelope_add_point(env, buff[2 * i], buff[2 * i + 1]) != GEONKICK_OK)
+                        return GEONKICK_ERROR;
+        }
+        return GEONKICK_OK;
 }
 
 void gkick_envelope_clear(struct gkick_envelope* env)
 {
-        struct gkick_envelope_point *p = env->first;
-        struct gkick_envelope_point *curr;
-        while (p != NULL) {
-                curr = p;
-                p = p->next;
-                free(curr);
-                env->npoints--;
-        }
-        env->first = env->last = NULL;
+        env->npoints = 0;
 }
 
 void
-gkick_envelope_remove_point(struct gkick_envelope *env, size_t index)
+gkick_envelope_copy(struct gkick_envelope *dst,
+                    const struct gkick_envelope *src)
 {
-        if (env == NULL)
+        if (dst == NULL || src == NULL)
                 return;
 
-        if (!(index >= 0 && index < env->npoints))
-                return;
+        memcpy(dst->x, src->x, src->npoints * sizeof(gkick_real));
+        memcpy(dst->y, src->y, src->npoints * sizeof(gkick_real));
+        dst->npoints = src->npoints;
+}
 
-        struct gkick_envelope_point *p = env->first;
-        size_t i = 0;
-        while (p) {
-                if (i == index) {
-                        if (p == env->first) {
-                                env->first = p->next;
-                        } else if (p == env->last) {
-                                env->last = p->prev;
-                        } else {
-                                p->prev->next = p->next;
-                                p->next->prev = p->prev;
-                        }
-                        free(p);
-                        env->npoints--;
-                        break;
-                }
-                p = p->next;
-                i++;
+enum geonkick_error
+gkick_envelope_remove_point(struct gkick_envelope *env, size_t index)
+{
+        if (env == NULL || index >= env->npoints) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
         }
+
+        size_t n = env->npoints - index - 1;
+        memmove(env->x + index, env->x + index + 1, n * sizeof(gkick_real));
+        memmove(env->y + index, env->y + index + 1, n * sizeof(gkick_real));
+        env->npoints--;
+        return GEONKICK_OK;
 }
 
-void
+enum geonkick_error
 gkick_envelope_update_point(struct gkick_envelope *env,
 			    size_t index,
 			    gkick_real x,
 			    gkick_real y)
 {
-        if (env == NULL)
-                return;
-
-        if (!(index >= 0 && index < env->npoints))
-                return;
+        if (env == NULL || index >= env->npoints) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
 
-        struct gkick_envelope_point *p = env->first;
-        size_t i = 0;
-        while (p) {
-                if (i == index) {
-                        p->x = x;
-                        p->y = y;
-                        break;
-                }
-                p = p->next;
-                i++;
+        /* Move the point to keep the points sorted if it was moved past its neighbours. */
+        if ((index > 0 && x < env->x[index - 1])
+            || (index + 1 < env->npoints && x > env->x[index + 1])) {
+                gkick_envelope_remove_point(env, index);
+                return gkick_envelope_add_point(env, x, y);
         }
+
+        env->x[index] = x;
+        env->y[index] = y;
+        return GEONKICK_OK;
 }
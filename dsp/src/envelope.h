@@ -24,35 +24,75 @@
 #ifndef GKICK_ENVELOPE_H
 #define GKICK_ENVELOPE_H
 
-#include "geonkick_internal.h"
+#include "geonkick.h"
 
-struct gkick_envelope_point {
-	struct gkick_envelope_point *prev;
-	struct gkick_envelope_point *next;
-	gkick_real x;
-	gkick_real y;
-};
+#define GKICK_ENVELOPE_MAX_POINTS GEONKICK_MAX_ENVELOPE_POINTS
 
+/**
+ * The envelope points are stored in two fixed size arrays
+ * of the x and y coordinates sorted by the x coordinate,
+ * so editing the envelope never allocates memory.
+ */
 struct gkick_envelope {
 	size_t npoints;
-	struct gkick_envelope_point *first;
-	struct gkick_envelope_point *last;
+	gkick_real x[GKICK_ENVELOPE_MAX_POINTS];
+	gkick_real y[GKICK_ENVELOPE_MAX_POINTS];
+};
+
+/**
+ * Position on the envelope of a rendering.
+ *
+ * Holds the segment of the last evaluated coordinate. While the
+ * coordinate advances monotonically, as during the synthesis,
+ * the evaluation only checks the current segment and moves
+ * to the next ones.
+ */
+struct gkick_envelope_cursor {
+        /* Index of the first point of the current segment. */
+        size_t segment;
 };
 
 struct gkick_envelope*
 gkick_envelope_create(void);
 
+gkick_real
+gkick_envelope_segment_value(const struct gkick_envelope *envelope,
+                             size_t i,
+                             gkick_real xm);
+
 gkick_real
 gkick_envelope_get_value(const struct gkick_envelope* envelope,
                          gkick_real xm);
 
-struct gkick_envelope_point*
-gkick_envelope_add_point(struct gkick_envelope *envelope,
-                         float x,
-                         float y);
+void
+gkick_envelope_cursor_reset(struct gkick_envelope_cursor *cursor);
 
-void gkick_envelope_add_sorted(struct gkick_envelope *envelope,
-			       struct gkick_envelope_point *point);
+size_t
+gkick_envelope_cursor_seek(const struct gkick_envelope *envelope,
+                           struct gkick_envelope_cursor *cursor,
+                           gkick_real xm);
+
+gkick_real
+gkick_envelope_cursor_value(const struct gkick_envelope *envelope,
+                            struct gkick_envelope_cursor *cursor,
+                            gkick_real xm);
+
+void
+gkick_envelope_render(const struct gkick_envelope *envelope,
+                      struct gkick_envelope_cursor *cursor,
+                      size_t offset,
+                      gkick_real dx,
+                      gkick_real *out,
+                      size_t size);
+
+size_t
+gkick_envelope_upper_bound(const struct gkick_envelope *envelope,
+                           gkick_real x);
+
+enum geonkick_error
+gkick_envelope_add_point(struct gkick_envelope *envelope,
+                         gkick_real x,
+                         gkick_real y);
 
 void gkick_envelope_destroy(struct gkick_envelope *envelope);
 
@@ -60,19 +100,25 @@ void gkick_envelope_get_points(struct gkick_envelope *env,
                                gkick_real **buff,
                                size_t *npoints);
 
-void gkick_envelope_set_points(struct gkick_envelope *env,
-			  const gkick_real *buff,
-			  size_t npoints);
+enum geonkick_error
+gkick_envelope_set_points(struct gkick_envelope *env,
+                          const gkick_real *buff,
+                          size_t npoints);
 
 
 void gkick_envelope_clear(struct gkick_envelope* env);
 
-void gkick_envelope_remove_point(struct gkick_envelope *env,
-                                 size_t index);
+void gkick_envelope_copy(struct gkick_envelope *dst,
+                         const struct gkick_envelope *src);
+
+enum geonkick_error
+gkick_envelope_remove_point(struct gkick_envelope *env,
+                            size_t index);
 
-void gkick_envelope_update_point(struct gkick_envelope *env,
-                                 size_t index,
-                                 gkick_real x,
-                                 gkick_real y);
+enum geonkick_error
+gkick_envelope_update_point(struct gkick_envelope *env,
+                            size_t index,
+                            gkick_real x,
+                            gkick_real y);
 
 #endif // GKICK_ENVELOPE_H
@@ -37,7 +37,6 @@ gkick_filter_new(struct gkick_filter **filter)
                 return GEONKICK_ERROR_MEM_ALLOC;
         }
         (*filter)->type = GEONKICK_FILTER_LOW_PASS;
-        (*filter)->queue_empty = 1;
 
         (*filter)->cutoff_env = gkick_envelope_create();
         if ((*filter)->cutoff_env == NULL) {
@@ -57,6 +56,7 @@ gkick_filter_new(struct gkick_filter **filter)
 
         (*filter)->cutoff_freq = GEONKICK_DEFAULT_FILTER_CUTOFF_FREQ;
         (*filter)->factor      = GEONKICK_DEFAULT_FILTER_FACTOR;
+        (*filter)->sample_rate = GEONKICK_DEFAULT_SAMPLE_RATE;
         gkick_filter_update_coefficents(*filter);
 
         return GEONKICK_OK;
@@ -71,10 +71,8 @@ gkick_filter_init(struct gkick_filter *filter)
         }
 
         gkick_filter_lock(filter);
-        filter->queue_empty = 1;
-        memset(filter->queue_l, 0, sizeof(filter->queue_l));
-        memset(filter->queue_b, 0, sizeof(filter->queue_b));
-        memset(filter->queue_h, 0, sizeof(filter->queue_h));
+        filter->state_l = 0.0f;
+        filter->state_b = 0.0f;
         gkick_filter_update_coefficents(filter);
         gkick_filter_unlock(filter);
 
@@ -91,6 +89,34 @@ void gkick_filter_free(struct gkick_filter **filter)
         }
 }
 
+/**
+ * Copies the filter parameters and the cutoff envelope.
+ * The filter state of the destination is not changed.
+ */
+enum geonkick_error
+gkick_filter_copy(struct gkick_filter *dst,
+                  struct gkick_filter *src)
+{
+        if (dst == NULL || src == NULL) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+
+        gkick_filter_lock(src);
+        dst->type        = src->type;
+        dst->cutoff_freq = src->cutoff_freq;
+        dst->factor      = src->factor;
+        dst->sample_rate = src->sample_rate;
+        gkick_envelope_copy(dst->cutoff_env, src->cutoff_env);
+        gkick_filter_unlock(src);
+
+        gkick_filter_lock(dst);
+        gkick_filter_update_coefficents(dst);
+        gkick_filter_unlock(dst);
+
+        return GEONKICK_OK;
+}
+
 void gkick_filter_lock(struct gkick_filter *filter)
 {
         pthread_mutex_lock(&filter->lock);
@@ -109,10 +135,25 @@ gkick_filter_update_coefficents(struct gkick_filter *filter)
                 return GEONKICK_ERROR;
         }
 
-        gkick_real F = 2.0f * sin(M_PI * filter->cutoff_freq / GEONKICK_SAMPLE_RATE);
-        gkick_real Q = filter->factor;
-        filter->coefficients[0] = F;
-        filter->coefficients[1] = Q;
+        filter->coefficients[0] = 2.0f * sin(M_PI * filter->cutoff_freq / filter->sample_rate);
+        filter->coefficients[1] = filter->factor;
+        return GEONKICK_OK;
+}
+
+enum geonkick_error
+gkick_filter_set_sample_rate(struct gkick_filter *filter,
+                             gkick_real rate)
+{
+        if (filter == NULL || rate < 1.0f) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+
+        gkick_filter_lock(filter);
+        filter->sample_rate = rate;
+        gkick_filter_update_coefficents(filter);
+        gkick_filter_unlock(filter);
+
         return GEONKICK_OK;
 }
 
@@ -209,57 +250,54 @@ gkick_filter_get_cutoff_freq(struct gkick_filter *filter, gkick_real *cutoff)
 }
 
 /**
- * gkick_filter_val function
+ * gkick_filter_process function
  *
  * Implements low, high, and band pass digital state variable filter.
+ * Filters a block of samples, the input and the output can be
+ * the same buffer. The filter is processed without the lock,
+ * only the synthesis snapshot of the filter is processed and it is
+ * used only by the synthesis thread.
+ *
+ * @param cutoff values of the cutoff envelope for every sample.
  */
 enum geonkick_error
-gkick_filter_val(struct gkick_filter *filter,
-                 gkick_real in_val,
-                 gkick_real *out_val,
-                 gkick_real env_x)
+gkick_filter_process(struct gkick_filter *filter,
+                     const gkick_real *in,
+                     gkick_real *out,
+                     size_t size,
+                     const gkick_real *cutoff)
 {
-        if (isnan(in_val) || in_val > 1.0f || in_val < -1.0f) {
-                *out_val = 0.0f;
-                return GEONKICK_ERROR;
-        }
-
-        if (filter == NULL || out_val == NULL) {
+        if (filter == NULL || in == NULL || out == NULL || cutoff == NULL) {
                 gkick_log_error("wrong arguments");
                 return GEONKICK_ERROR;
         }
 
-        gkick_filter_lock(filter);
-
-        gkick_real *l = filter->queue_l;
-        gkick_real *b = filter->queue_b;
-        gkick_real *h = filter->queue_h;
-        gkick_real F = gkick_envelope_get_value(filter->cutoff_env, env_x) * filter->coefficients[0];
-        gkick_real Q = filter->coefficients[1];
-        size_t n = 1;
-        if (filter->queue_empty) {
-                l[n - 1] = l[n] = 0;
-                b[n - 1] = b[n] = 0;
-                h[n - 1] = h[n] = 0;
-                filter->queue_empty = 0;
-        } else {
-                h[n - 1] = h[n];
-                b[n - 1] = b[n];
-                l[n - 1] = l[n];
+        enum gkick_filter_type type = filter->type;
+        gkick_real l = filter->state_l;
+        gkick_real b = filter->state_b;
+        gkick_real f = filter->coefficients[0];
+        gkick_real q = filter->coefficients[1];
+        for (size_t i = 0; i < size; i++) {
+                gkick_real x = in[i];
+                /* Skip invalid samples (out of range or NaN). */
+                if (!(x >= -1.0f && x <= 1.0f)) {
+                        out[i] = 0.0f;
+                        continue;
+                }
+
+                gkick_real F = cutoff[i] * f;
+                gkick_real h = x - l - q * b;
+                b += F * h;
+                l += F * b;
+                if (type == GEONKICK_FILTER_HIGH_PASS)
+                        out[i] = h;
+                else if (type == GEONKICK_FILTER_BAND_PASS)
+                        out[i] = b;
+                else
+                        out[i] = l;
         }
-        h[n] = in_val - l[n - 1] - Q * b[n - 1];
-        b[n] = F * h[n] + b[n - 1];
-        l[n] = F * b[n] + l[n - 1];
-
-        gkick_real val = 0.0f;
-        if (filter->type == GEONKICK_FILTER_HIGH_PASS)
-                val = h[n];
-        else if (filter->type == GEONKICK_FILTER_BAND_PASS)
-                val = b[n];
-        else
-                val = l[n];
-        *out_val = val;
-        gkick_filter_unlock(filter);
+        filter->state_l = l;
+        filter->state_b = b;
 
         return GEONKICK_OK;
 }
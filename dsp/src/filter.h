@@ -39,13 +39,17 @@ struct gkick_filter {
         /* Filter damping factor. */
         gkick_real factor;
 
-        /* A queue of a three elements */
-        gkick_real queue_l[2];
-        gkick_real queue_b[2];
-        gkick_real queue_h[2];
-        char queue_empty;
+        /* Sample rate the coefficients are calculated for. */
+        gkick_real sample_rate;
 
-        /* Filter coefficients. */
+        /* Low pass and band pass integrators of the filter. */
+        gkick_real state_l;
+        gkick_real state_b;
+
+        /**
+         * Filter coefficients: the frequency coefficient for
+         * the cutoff envelope value 1.0 and the damping coefficient.
+         */
         gkick_real coefficients[2];
 
         /* Filter cutoff envelope. */
@@ -61,6 +65,10 @@ gkick_filter_init(struct gkick_filter *filter);
 
 void gkick_filter_free(struct gkick_filter **filter);
 
+enum geonkick_error
+gkick_filter_copy(struct gkick_filter *dst,
+                  struct gkick_filter *src);
+
 void gkick_filter_lock(struct gkick_filter *filter);
 
 void gkick_filter_unlock(struct gkick_filter *filter);
@@ -68,6 +76,10 @@ void gkick_filter_unlock(struct gkick_filter *filter);
 enum geonkick_error
 gkick_filter_update_coefficents(struct gkick_filter *filter);
 
+enum geonkick_error
+gkick_filter_set_sample_rate(struct gkick_filter *filter,
+                             gkick_real rate);
+
 enum geonkick_error
 gkick_filter_set_type(struct gkick_filter *filter,
                       enum gkick_filter_type type);
@@ -93,9 +105,10 @@ gkick_filter_get_factor(struct gkick_filter *filter,
                         gkick_real *factor);
 
 enum geonkick_error
-gkick_filter_val(struct gkick_filter *filter,
-                 gkick_real in_val,
-                 gkick_real *out_val,
-                 gkick_real env_x);
+gkick_filter_process(struct gkick_filter *filter,
+                     const gkick_real *in,
+                     gkick_real *out,
+                     size_t size,
+                     const gkick_real *cutoff);
 
 #endif // GEONKICK_FILTER_H
@@ -40,6 +40,7 @@ geonkick_create(struct geonkick **kick)
 	strcpy((*kick)->name, "Geonkick");
         (*kick)->synthesis_on = false;
         (*kick)->per_index = 0;
+        (*kick)->sample_rate = GEONKICK_DEFAULT_SAMPLE_RATE;
 
 	if (pthread_mutex_init(&(*kick)->lock, NULL) != 0) {
                 gkick_log_error("error on init mutex");
@@ -67,6 +68,14 @@ geonkick_create(struct geonkick **kick)
                 geonkick_set_percussion_channel(*kick, i, i);
         }
 
+        /* Follow the sample rate of the audio server if there is one. */
+        int rate = gkick_audio_get_sample_rate((*kick)->audio);
+        if (rate > 0)
+                geonkick_set_sample_rate(*kick, rate);
+        gkick_audio_set_sample_rate_callback((*kick)->audio,
+                                             geonkick_sample_rate_changed,
+                                             *kick);
+
 	if (geonkick_worker_init(*kick) != GEONKICK_OK) {
 		gkick_log_error("can't init worker");
 		geonkick_free(kick);
@@ -165,12 +174,37 @@ geonkick_osc_envelope_add_point(struct geonkick *kick,
         return res;
 }
 
+/**
+ * Sets the sample rate of the synthesis. All the active
+ * percussions are synthesized again at the new sample rate.
+ */
 enum geonkick_error
 geonkick_set_sample_rate(struct geonkick *kick, gkick_real rate)
 {
+        if (kick == NULL || rate < 1.0f) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+
+        if (kick->sample_rate == (int)rate)
+                return GEONKICK_OK;
+
+        kick->sample_rate = rate;
+        for (size_t i = 0; i < GEONKICK_MAX_PERCUSSIONS; i++) {
+                if (gkick_synth_set_sample_rate(kick->synths[i], rate) != GEONKICK_OK)
+                        return GEONKICK_ERROR;
+        }
+        geonkick_worker_wakeup(kick);
         return GEONKICK_OK;
 }
 
+/* Called by the audio module when the sample rate of the audio host changes. */
+void
+geonkick_sample_rate_changed(void *arg, int rate)
+{
+        geonkick_set_sample_rate((struct geonkick*)arg, rate);
+}
+
 enum geonkick_error
 geonkick_osc_envelope_get_points(struct geonkick *kick,
 				 size_t osc_index,
@@ -275,6 +309,37 @@ geonkick_osc_is_fm(struct geonkick *kick, size_t index, bool *is_fm)
         return gkick_synth_osc_is_fm(kick->synths[kick->per_index], index, is_fm);
 }
 
+enum geonkick_error
+geonkick_osc_set_band_limited(struct geonkick *kick,
+                              size_t index,
+                              bool band_limited)
+{
+        if (kick == NULL) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+
+        enum geonkick_error res;
+        res = gkick_synth_osc_set_band_limited(kick->synths[kick->per_index],
+                                               index,
+                                               band_limited);
+        if (res == GEONKICK_OK && kick->synths[kick->per_index]->buffer_update)
+                geonkick_worker_wakeup(kick);
+        return res;
+}
+
+enum geonkick_error
+geonkick_osc_is_band_limited(struct geonkick *kick,
+                             size_t index,
+                             bool *band_limited)
+{
+        if (kick == NULL || band_limited == NULL)
+                return GEONKICK_ERROR;
+        return gkick_synth_osc_is_band_limited(kick->synths[kick->per_index],
+                                               index,
+                                               band_limited);
+}
+
 enum geonkick_error
 geonkick_set_osc_function(struct geonkick *kick,
 			  size_t osc_index,
@@ -943,13 +1008,11 @@ enum geonkick_error
 geonkick_get_sample_rate(struct geonkick *kick,
                          int *sample_rate)
 {
-        GEONKICK_UNUSED(kick);
-
-        if (sample_rate == NULL) {
+        if (kick == NULL || sample_rate == NULL) {
                 gkick_log_error("wrong arugments");
                 return GEONKICK_ERROR;
         }
-        *sample_rate = GEONKICK_SAMPLE_RATE;
+        *sample_rate = kick->sample_rate;
         return GEONKICK_OK;
 }
 
@@ -966,7 +1029,7 @@ geonkick_enable_synthesis(struct geonkick *kick,
         if (kick->synthesis_on) {
                 for (size_t i = 0; i < GEONKICK_MAX_PERCUSSIONS; i++) {
                         if (kick->synths[i]->is_active)
-                                kick->synths[i]->buffer_update = true;
+                                gkick_synth_params_changed(kick->synths[i]);
                 }
                 geonkick_worker_wakeup(kick);
         }
@@ -983,6 +1046,28 @@ geonkick_get_audio_frame(struct geonkick *kick,
                                      val);
 }
 
+enum geonkick_error
+geonkick_render_block(struct geonkick *kick,
+                      float **channels,
+                      size_t nchannels,
+                      size_t offset,
+                      size_t nframes,
+                      const struct gkick_note_event *events,
+                      size_t nevents)
+{
+        if (kick == NULL || channels == NULL || (events == NULL && nevents > 0)) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+        return gkick_audio_render_block(kick->audio,
+                                        channels,
+                                        nchannels,
+                                        offset,
+                                        nframes,
+                                        events,
+                                        nevents);
+}
+
 enum geonkick_error
 geonkick_compressor_enable(struct geonkick *kick,
                            int enable)
@@ -1291,6 +1376,34 @@ geonkick_distortion_get_drive(struct geonkick *kick,
                                                 drive);
 }
 
+enum geonkick_error
+geonkick_distortion_set_oversampling(struct geonkick *kick,
+                                     int factor)
+{
+        if (kick == NULL) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+        enum geonkick_error res;
+        res = gkick_synth_distortion_set_oversampling(kick->synths[kick->per_index],
+                                                      factor);
+        if (res == GEONKICK_OK && kick->synths[kick->per_index]->buffer_update)
+                geonkick_worker_wakeup(kick);
+        return res;
+}
+
+enum geonkick_error
+geonkick_distortion_get_oversampling(struct geonkick *kick,
+                                     int *factor)
+{
+        if (kick == NULL || factor == NULL) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+        return gkick_synth_distortion_get_oversampling(kick->synths[kick->per_index],
+                                                       factor);
+}
+
 int geonkick_is_module_enabed(struct geonkick *kick,
                               enum GEONKICK_MODULE module)
 {
@@ -1488,12 +1601,45 @@ geonkick_worker_init(struct geonkick *kick)
 	geonkick_lock(kick);
 	struct gkick_worker *worker = &kick->worker;
 	worker->running = false;
-        if (pthread_cond_init(&worker->condition_var, NULL) != 0) {
+
+        /* The debounce timeouts must not depend on the wall clock changes. */
+        pthread_condattr_t attr;
+        if (pthread_condattr_init(&attr) != 0) {
+                gkick_log_error("can't init worker condition variable");
+		geonkick_unlock(kick);
+		return GEONKICK_ERROR;
+        }
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        int res = pthread_cond_init(&worker->condition_var, &attr);
+        pthread_condattr_destroy(&attr);
+        if (res != 0) {
                 gkick_log_error("can't init worker condition variable");
 		geonkick_unlock(kick);
 		return GEONKICK_ERROR;
 	}
 	worker->cond_var_initilized = true;
+
+        /* Synthesize the percussions that were changed before the start. */
+        worker->update_requested = true;
+        worker->synthesis_duration = 0;
+        worker->synthesis_end.tv_sec = 0;
+        worker->synthesis_end.tv_nsec = 0;
+
+        if (pthread_mutex_init(&worker->jobs_lock, NULL) != 0
+            || pthread_mutex_init(&worker->pool_lock, NULL) != 0
+            || pthread_cond_init(&worker->jobs_cond, NULL) != 0
+            || pthread_cond_init(&worker->jobs_done_cond, NULL) != 0) {
+                gkick_log_error("can't init worker jobs synchronization");
+		geonkick_unlock(kick);
+		return GEONKICK_ERROR;
+        }
+        worker->jobs_sync_initilized = true;
+        worker->jobs_number  = 0;
+        worker->jobs_next    = 0;
+        worker->jobs_pending = 0;
+
+        worker->synthesis_threads_number = 0;
+        worker->synthesis_threads_limit = geonkick_worker_default_threads();
 	geonkick_unlock(kick);
 	return GEONKICK_OK;
 }
@@ -1501,30 +1647,61 @@ geonkick_worker_init(struct geonkick *kick)
 enum geonkick_error
 geonkick_worker_start(struct geonkick *kick)
 {
-        kick->worker.running = true;
-        if (pthread_create(&kick->worker.thread, NULL,
+        struct gkick_worker *worker = &kick->worker;
+        pthread_mutex_lock(&worker->pool_lock);
+        worker->running = true;
+        if (geonkick_worker_resize_pool(kick, worker->synthesis_threads_limit) != GEONKICK_OK) {
+                worker->running = false;
+                pthread_mutex_unlock(&worker->pool_lock);
+                return GEONKICK_ERROR;
+        }
+
+        if (pthread_create(&worker->thread, NULL,
                            geonkick_worker_thread, kick) != 0) {
                 gkick_log_error("can't create worker thread");
-                kick->worker.running = false;
+                worker->running = false;
+                pthread_mutex_unlock(&worker->pool_lock);
                 return GEONKICK_ERROR;
         }
+        pthread_mutex_unlock(&worker->pool_lock);
         return GEONKICK_OK;
 }
 
 void geonkick_worker_destroy(struct geonkick *kick)
 {
 	struct gkick_worker *worker = &kick->worker;
-	if (worker->running)
+        if (worker->jobs_sync_initilized)
+                pthread_mutex_lock(&worker->pool_lock);
+	if (worker->running) {
+                geonkick_lock(kick);
 		worker->running = false;
-        geonkick_lock(kick);
-        pthread_cond_signal(&kick->worker.condition_var);
-        geonkick_unlock(kick);
-	pthread_join(worker->thread, NULL);
+                pthread_cond_signal(&kick->worker.condition_var);
+                geonkick_unlock(kick);
+                pthread_join(worker->thread, NULL);
+        }
+
+        if (worker->jobs_sync_initilized) {
+                pthread_mutex_lock(&worker->jobs_lock);
+                pthread_cond_broadcast(&worker->jobs_cond);
+                pthread_mutex_unlock(&worker->jobs_lock);
+        }
+        for (size_t i = 0; i < worker->synthesis_threads_number; i++)
+                pthread_join(worker->synthesis_threads[i].thread, NULL);
+        worker->synthesis_threads_number = 0;
+        if (worker->jobs_sync_initilized)
+                pthread_mutex_unlock(&worker->pool_lock);
 
 	geonkick_lock(kick);
 	if (worker->cond_var_initilized)
 		pthread_cond_destroy(&worker->condition_var);
 	worker->cond_var_initilized = false;
+        if (worker->jobs_sync_initilized) {
+                pthread_cond_destroy(&worker->jobs_done_cond);
+                pthread_cond_destroy(&worker->jobs_cond);
+                pthread_mutex_destroy(&worker->jobs_lock);
+                pthread_mutex_destroy(&worker->pool_lock);
+        }
+        worker->jobs_sync_initilized = false;
 	geonkick_unlock(kick);
 }
 
@@ -1537,42 +1714,248 @@ void *geonkick_worker_thread(void *arg)
 
 	struct geonkick *kick = (struct geonkick*)arg;
 	struct gkick_worker *worker = &kick->worker;
-	while (worker->running) {
-		/**
-                 * Ignore too many updates.
-                 * The last udpates will be processed.
+        geonkick_lock(kick);
+	while (true) {
+                while (worker->running && !worker->update_requested)
+                        pthread_cond_wait(&worker->condition_var, &kick->lock);
+                if (!worker->running)
+                        break;
+
+                geonkick_worker_debounce(kick);
+                if (!worker->running)
+                        break;
+
+                /**
+                 * The updates requested from now on are handled by
+                 * the next synthesis, the current one takes all
+                 * the updates requested until the snapshots.
                  */
-                usleep(40000);
-                bool update_buffers = false;
-                for (size_t i = 0; i < GEONKICK_MAX_PERCUSSIONS; i++) {
-                        struct gkick_synth *synth = kick->synths[i];
-                        if (synth != NULL && synth->is_active && synth->buffer_update) {
-                                update_buffers = true;
-                                break;
-                        }
-                }
+                worker->update_requested = false;
+                geonkick_unlock(kick);
+
+                struct timespec start;
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                geonkick_worker_process_jobs(kick);
+
+                geonkick_lock(kick);
+                clock_gettime(CLOCK_MONOTONIC, &worker->synthesis_end);
+                worker->synthesis_duration = geonkick_worker_elapsed(&start,
+                                                                     &worker->synthesis_end);
+	}
+        geonkick_unlock(kick);
+
+        return NULL;
+}
+
+/**
+ * Delays the synthesis during a burst of updates, like the dragging
+ * of an envelope point, so the updates are coalesced into one synthesis.
+ * The delay is about the duration of the last synthesis, so the worker
+ * doesn't synthesize faster than it can. An isolated update, that comes
+ * after a quiet interval, is synthesized without delay.
+ * Must be called with the geonkick lock.
+ */
+void
+geonkick_worker_debounce(struct geonkick *kick)
+{
+        struct gkick_worker *worker = &kick->worker;
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (geonkick_worker_elapsed(&worker->synthesis_end, &now)
+            > GEONKICK_WORKER_BURST_INTERVAL)
+                return;
+
+        long long delay = worker->synthesis_duration;
+        if (delay < GEONKICK_WORKER_MIN_DEBOUNCE)
+                delay = GEONKICK_WORKER_MIN_DEBOUNCE;
+        else if (delay > GEONKICK_WORKER_MAX_DEBOUNCE)
+                delay = GEONKICK_WORKER_MAX_DEBOUNCE;
+
+        struct timespec deadline = now;
+        deadline.tv_sec  += (deadline.tv_nsec + delay) / 1000000000LL;
+        deadline.tv_nsec  = (deadline.tv_nsec + delay) % 1000000000LL;
+        while (worker->running
+               && pthread_cond_timedwait(&worker->condition_var,
+                                         &kick->lock,
+                                         &deadline) != ETIMEDOUT);
+}
+
+/* Returns the time in nanoseconds elapsed between two moments. */
+long long
+geonkick_worker_elapsed(const struct timespec *from,
+                        const struct timespec *to)
+{
+        return (long long)(to->tv_sec - from->tv_sec) * 1000000000LL
+                + (to->tv_nsec - from->tv_nsec);
+}
+
+/**
+ * Posts one job for every percussion that needs to be
+ * synthesized and waits until the pool processes all of them.
+ */
+void
+geonkick_worker_process_jobs(struct geonkick *kick)
+{
+        struct gkick_worker *worker = &kick->worker;
+        pthread_mutex_lock(&worker->jobs_lock);
+        worker->jobs_number = 0;
+        worker->jobs_next   = 0;
+        for (size_t i = 0; i < GEONKICK_MAX_PERCUSSIONS; i++) {
+                struct gkick_synth *synth = kick->synths[i];
+                if (synth != NULL && synth->is_active && synth->buffer_update)
+                        worker->jobs[worker->jobs_number++] = i;
+        }
+        worker->jobs_pending = worker->jobs_number;
+
+        if (worker->jobs_pending > 0) {
+                pthread_cond_broadcast(&worker->jobs_cond);
+                while (worker->jobs_pending > 0)
+                        pthread_cond_wait(&worker->jobs_done_cond, &worker->jobs_lock);
+        }
+        pthread_mutex_unlock(&worker->jobs_lock);
+}
+
+void *geonkick_worker_synthesis_thread(void *arg)
+{
+	if (arg == NULL) {
+		gkick_log_error("wrong arugments");
+		return NULL;
+	}
+
+	struct gkick_synthesis_thread *thread = (struct gkick_synthesis_thread*)arg;
+	struct geonkick *kick = thread->kick;
+	struct gkick_worker *worker = &kick->worker;
+        pthread_mutex_lock(&worker->jobs_lock);
+	while (true) {
+                /**
+                 * The pool was reduced, the jobs are processed by the
+                 * other threads, the first thread never exits here.
+                 */
+                if (thread->index >= worker->synthesis_threads_limit)
+                        break;
 
-		if (!update_buffers) {
-		        pthread_cond_wait(&worker->condition_var, &kick->lock);
-                        geonkick_unlock(kick);
+                /* Posted jobs are finished even if the worker is stopping. */
+                if (worker->jobs_next >= worker->jobs_number) {
                         if (!worker->running)
                                 break;
+                        pthread_cond_wait(&worker->jobs_cond, &worker->jobs_lock);
+                        continue;
                 }
 
-                for (size_t i = 0; i < GEONKICK_MAX_PERCUSSIONS; i++) {
-                        struct gkick_synth *synth = kick->synths[i];
-                        if (synth != NULL && synth->is_active && synth->buffer_update)
-                                gkick_synth_process(synth);
-                }
+                struct gkick_synth *synth = kick->synths[worker->jobs[worker->jobs_next++]];
+                pthread_mutex_unlock(&worker->jobs_lock);
+                gkick_synth_process(synth);
+                pthread_mutex_lock(&worker->jobs_lock);
+
+                if (--worker->jobs_pending == 0)
+                        pthread_cond_signal(&worker->jobs_done_cond);
 	}
+        pthread_mutex_unlock(&worker->jobs_lock);
 
         return NULL;
 }
 
+/* Number of the cores but not more than the default maximum. */
+size_t
+geonkick_worker_default_threads(void)
+{
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        if (cores < 1)
+                cores = 1;
+        else if (cores > GEONKICK_DEFAULT_SYNTHESIS_THREADS)
+                cores = GEONKICK_DEFAULT_SYNTHESIS_THREADS;
+        return cores;
+}
+
+/**
+ * Changes the number of the synthesis threads while the worker runs.
+ * The threads out of the new limit exit between the jobs and are
+ * joined, the missing threads are created.
+ *
+ * Must be called with the pool lock.
+ */
+enum geonkick_error
+geonkick_worker_resize_pool(struct geonkick *kick, size_t number)
+{
+        struct gkick_worker *worker = &kick->worker;
+        pthread_mutex_lock(&worker->jobs_lock);
+        worker->synthesis_threads_limit = number;
+        pthread_cond_broadcast(&worker->jobs_cond);
+        pthread_mutex_unlock(&worker->jobs_lock);
+
+        while (worker->synthesis_threads_number > number) {
+                worker->synthesis_threads_number--;
+                pthread_join(worker->synthesis_threads[worker->synthesis_threads_number].thread,
+                             NULL);
+        }
+
+        while (worker->synthesis_threads_number < number) {
+                struct gkick_synthesis_thread *thread;
+                thread = &worker->synthesis_threads[worker->synthesis_threads_number];
+                thread->kick  = kick;
+                thread->index = worker->synthesis_threads_number;
+                if (pthread_create(&thread->thread, NULL,
+                                   geonkick_worker_synthesis_thread, thread) != 0) {
+                        gkick_log_error("can't create synthesis thread");
+                        break;
+                }
+                worker->synthesis_threads_number++;
+        }
+
+        if (worker->synthesis_threads_number < number) {
+                pthread_mutex_lock(&worker->jobs_lock);
+                worker->synthesis_threads_limit = worker->synthesis_threads_number;
+                pthread_mutex_unlock(&worker->jobs_lock);
+        }
+
+        return worker->synthesis_threads_number > 0 ? GEONKICK_OK : GEONKICK_ERROR;
+}
+
+enum geonkick_error
+geonkick_set_synthesis_threads(struct geonkick *kick,
+                               size_t number)
+{
+        if (kick == NULL || number > GEONKICK_MAX_SYNTHESIS_THREADS) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+
+        if (number == 0)
+                number = geonkick_worker_default_threads();
+
+        struct gkick_worker *worker = &kick->worker;
+        enum geonkick_error res = GEONKICK_OK;
+        pthread_mutex_lock(&worker->pool_lock);
+        if (worker->running) {
+                res = geonkick_worker_resize_pool(kick, number);
+        } else {
+                pthread_mutex_lock(&worker->jobs_lock);
+                worker->synthesis_threads_limit = number;
+                pthread_mutex_unlock(&worker->jobs_lock);
+        }
+        pthread_mutex_unlock(&worker->pool_lock);
+        return res;
+}
+
+enum geonkick_error
+geonkick_get_synthesis_threads(struct geonkick *kick,
+                               size_t *number)
+{
+        if (kick == NULL || number == NULL) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+        pthread_mutex_lock(&kick->worker.pool_lock);
+        *number = kick->worker.synthesis_threads_number;
+        pthread_mutex_unlock(&kick->worker.pool_lock);
+        return GEONKICK_OK;
+}
+
 void geonkick_worker_wakeup(struct geonkick *kick)
 {
         if (kick->synthesis_on) {
                 geonkick_lock(kick);
+                kick->worker.update_requested = true;
                 pthread_cond_signal(&kick->worker.condition_var);
                 geonkick_unlock(kick);
         }
@@ -1607,8 +1990,7 @@ geonkick_enable_percussion(struct geonkick *kick,
                 return GEONKICK_ERROR;
         }
         kick->synths[index]->is_active  = enable;
-        kick->audio->audio_outputs[index]->enabled = enable;
-	return GEONKICK_OK;
+	return gkick_audio_enable_output(kick->audio, index, enable);
 }
 
 enum geonkick_error
@@ -1722,7 +2104,7 @@ geonkick_set_percussion_channel(struct geonkick *kick,
                 gkick_log_error("wrong arguments");
                 return GEONKICK_ERROR;
         }
-        return gkick_audio_output_set_channel(kick->synths[id]->output, channel);
+        return gkick_audio_set_output_channel(kick->audio, id, channel);
 }
 
 enum geonkick_error
@@ -1737,3 +2119,55 @@ geonkick_get_percussion_channel(struct geonkick *kick,
         return gkick_audio_output_get_channel(kick->synths[id]->output,
                                               channel);
 }
+
+enum geonkick_error
+geonkick_set_percussion_polyphony(struct geonkick *kick,
+                                  size_t id,
+                                  size_t polyphony)
+{
+        if (kick == NULL || id > GEONKICK_MAX_PERCUSSIONS - 1) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+        return gkick_audio_output_set_polyphony(kick->synths[id]->output,
+                                                polyphony);
+}
+
+enum geonkick_error
+geonkick_get_percussion_polyphony(struct geonkick *kick,
+                                  size_t id,
+                                  size_t *polyphony)
+{
+        if (kick == NULL || polyphony == NULL || id > GEONKICK_MAX_PERCUSSIONS - 1) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+        return gkick_audio_output_get_polyphony(kick->synths[id]->output,
+                                                polyphony);
+}
+
+enum geonkick_error
+geonkick_set_percussion_voice_stealing(struct geonkick *kick,
+                                       size_t id,
+                                       enum geonkick_voice_stealing stealing)
+{
+        if (kick == NULL || id > GEONKICK_MAX_PERCUSSIONS - 1) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+        return gkick_audio_output_set_voice_stealing(kick->synths[id]->output,
+                                                     stealing);
+}
+
+enum geonkick_error
+geonkick_get_percussion_voice_stealing(struct geonkick *kick,
+                                       size_t id,
+                                       enum geonkick_voice_stealing *stealing)
+{
+        if (kick == NULL || stealing == NULL || id > GEONKICK_MAX_PERCUSSIONS - 1) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+        return gkick_audio_output_get_voice_stealing(kick->synths[id]->output,
+                                                     stealing);
+}
@@ -76,6 +76,21 @@ enum gkick_key_state {
         GKICK_KEY_STATE_RELEASED = 2
 };
 
+/* Which voice to take when all the voices of an output are playing. */
+enum geonkick_voice_stealing {
+        GEONKICK_VOICE_STEALING_OLDEST   = 0,
+        GEONKICK_VOICE_STEALING_QUIETEST = 1
+};
+
+/* Note event for the block rendering. */
+struct gkick_note_event {
+        /* Offset of the event in frames from the beginning of the channel buffers. */
+        size_t offset;
+        enum gkick_key_state state;
+        int note;
+        int velocity;
+};
+
 enum geonkick_envelope_type {
         GEONKICK_AMPLITUDE_ENVELOPE = 0,
         GEONKICK_FREQUENCY_ENVELOPE = 1,
@@ -126,6 +141,22 @@ enum geonkick_channel_type {
 */
 #define GEONKICK_MAX_CHANNELS GEONKICK_MAX_PERCUSSIONS
 
+/**
+ * Maximum and default number of the voices of
+ * a percussion that can play at the same time.
+ */
+#define GEONKICK_MAX_POLYPHONY 8
+#define GEONKICK_DEFAULT_POLYPHONY 4
+
+/* Maximum number of points of an envelope. */
+#define GEONKICK_MAX_ENVELOPE_POINTS 256
+
+/**
+ * Default maximum number of the synthesis threads of an instance,
+ * kept low so many plugin instances don't oversubscribe the cores.
+ */
+#define GEONKICK_DEFAULT_SYNTHESIS_THREADS 4
+
 struct geonkick;
 
 enum geonkick_error
@@ -203,6 +234,20 @@ geonkick_osc_is_fm(struct geonkick *kick,
                    size_t index,
                    bool *is_fm);
 
+/**
+ * Enables the band-limited (PolyBLEP) square,
+ * triangle and sawtooth waveforms of the oscillator.
+ */
+enum geonkick_error
+geonkick_osc_set_band_limited(struct geonkick *kick,
+                              size_t index,
+                              bool band_limited);
+
+enum geonkick_error
+geonkick_osc_is_band_limited(struct geonkick *kick,
+                             size_t index,
+                             bool *band_limited);
+
 enum geonkick_error
 geonkick_set_osc_function(struct geonkick *kick,
 			  size_t osc_index,
@@ -414,6 +459,23 @@ geonkick_osc_filter_is_enabled(struct geonkick *kick,
                                size_t osc_index,
                                int *enable);
 
+enum geonkick_error
+geonkick_set_sample_rate(struct geonkick *kick,
+                         gkick_real rate);
+
+/**
+ * Sets the number of the threads that synthesize the percussions.
+ * The value 0 sets the default number of threads, that is the number
+ * of the cores but not more than GEONKICK_DEFAULT_SYNTHESIS_THREADS.
+ */
+enum geonkick_error
+geonkick_set_synthesis_threads(struct geonkick *kick,
+                               size_t number);
+
+enum geonkick_error
+geonkick_get_synthesis_threads(struct geonkick *kick,
+                               size_t *number);
+
 enum geonkick_error
 geonkick_get_sample_rate(struct geonkick *kick,
                          int *sample_rate);
@@ -427,6 +489,25 @@ geonkick_get_audio_frame(struct geonkick *kick,
                          int channel,
                          gkick_real *val);
 
+/**
+ * Renders the frames from the offset to the offset plus nframes
+ * into the channel buffers. The block is split at the event offsets.
+ * The events must be sorted ascending by the offset, an event with
+ * an offset before the already rendered frames is applied at the
+ * current frame. A NULL channel buffer is skipped.
+ *
+ * This function must be called
+ * only from the audio thread.
+ */
+enum geonkick_error
+geonkick_render_block(struct geonkick *kick,
+                      float **channels,
+                      size_t nchannels,
+                      size_t offset,
+                      size_t nframes,
+                      const struct gkick_note_event *events,
+                      size_t nevents);
+
 enum geonkick_error
 geonkick_compressor_enable(struct geonkick *kick,
                            int enable);
@@ -515,6 +596,18 @@ enum geonkick_error
 geonkick_distortion_get_drive(struct geonkick *kick,
                               gkick_real *drive);
 
+/**
+ * Sets the oversampling factor (1, 2 or 4) of the distortion
+ * waveshaper, used to reduce the aliasing.
+ */
+enum geonkick_error
+geonkick_distortion_set_oversampling(struct geonkick *kick,
+                                     int factor);
+
+enum geonkick_error
+geonkick_distortion_get_oversampling(struct geonkick *kick,
+                                     int *factor);
+
 int geonkick_is_module_enabed(struct geonkick *kick,
                               enum GEONKICK_MODULE module);
 
@@ -621,6 +714,26 @@ geonkick_get_percussion_channel(struct geonkick *kick,
                                 size_t id,
                                 size_t *channel);
 
+enum geonkick_error
+geonkick_set_percussion_polyphony(struct geonkick *kick,
+                                  size_t id,
+                                  size_t polyphony);
+
+enum geonkick_error
+geonkick_get_percussion_polyphony(struct geonkick *kick,
+                                  size_t id,
+                                  size_t *polyphony);
+
+enum geonkick_error
+geonkick_set_percussion_voice_stealing(struct geonkick *kick,
+                                       size_t id,
+                                       enum geonkick_voice_stealing stealing);
+
+enum geonkick_error
+geonkick_get_percussion_voice_stealing(struct geonkick *kick,
+                                       size_t id,
+                                       enum geonkick_voice_stealing *stealing);
+
 
 #ifdef __cplusplus
 }
@@ -31,23 +31,101 @@
 
 #include <pthread.h>
 #include <stdatomic.h>
+#include <time.h>
 
-#define GEONKICK_SAMPLE_RATE 48000
+/**
+ * Sample rate used until the audio host provides one.
+ * The sample rate is set at runtime by geonkick_set_sample_rate.
+ */
+#define GEONKICK_DEFAULT_SAMPLE_RATE 48000
 
 /* Kick maximum length in seconds. */
 #define GEONKICK_MAX_LENGTH 4.0f
-#define GEONKICK_MAX_KICK_BUFFER_SIZE  (4 * GEONKICK_SAMPLE_RATE)
+/* Kick maximum buffer size at the default sample rate. */
+#define GEONKICK_MAX_KICK_BUFFER_SIZE  (4 * GEONKICK_DEFAULT_SAMPLE_RATE)
+
+/**
+ * Maximum number of the synthesis threads.
+ * There is no gain of having more threads than percussions.
+ */
+#define GEONKICK_MAX_SYNTHESIS_THREADS GEONKICK_MAX_PERCUSSIONS
+
+struct geonkick;
+
+struct gkick_synthesis_thread {
+        struct geonkick *kick;
+        pthread_t thread;
+        /* The thread exits when the index is out of the pool limit. */
+        size_t index;
+};
+
+/**
+ * Updates requested within this interval (in nanoseconds) from
+ * the end of the previous synthesis are considered a burst.
+ */
+#define GEONKICK_WORKER_BURST_INTERVAL 50000000LL
+
+/**
+ * Limits (in nanoseconds) of the delay used to coalesce a burst
+ * of updates. The delay follows the duration of the last synthesis.
+ */
+#define GEONKICK_WORKER_MIN_DEBOUNCE 2000000LL
+#define GEONKICK_WORKER_MAX_DEBOUNCE 40000000LL
 
 struct gkick_worker {
 	/* The worker thread. */
         pthread_t thread;
 
-	/* Condition variable used for the worker thread. */
+	/**
+         * Condition variable used for the worker thread,
+         * used with the geonkick lock.
+         */
         pthread_cond_t condition_var;
 	bool cond_var_initilized;
 
 	/* Specifies if the worker is running. */
 	atomic_bool running;
+
+        /**
+         * Set by the updates of the parameters and cleared by
+         * the worker thread, both under the geonkick lock.
+         * Many updates are coalesced in one synthesis that
+         * takes the latest parameters.
+         */
+        bool update_requested;
+
+        /* Time when the last synthesis ended (CLOCK_MONOTONIC). */
+        struct timespec synthesis_end;
+        /* Duration of the last synthesis in nanoseconds. */
+        long long synthesis_duration;
+
+        /**
+         * Pool of synthesis threads. The worker thread
+         * posts one job per percussion to be synthesized and
+         * the jobs are processed in parallel by the pool.
+         */
+        struct gkick_synthesis_thread synthesis_threads[GEONKICK_MAX_SYNTHESIS_THREADS];
+        /* Number of the created threads, under the pool lock. */
+        size_t synthesis_threads_number;
+        /**
+         * Number of the threads the pool should have, changed
+         * under both the pool lock and the jobs lock.
+         */
+        size_t synthesis_threads_limit;
+        /* Serializes the start, the resize and the stop of the pool. */
+        pthread_mutex_t pool_lock;
+
+        /* Indexes of the percussions to be synthesized. */
+        size_t jobs[GEONKICK_MAX_PERCUSSIONS];
+        size_t jobs_number;
+        /* Index of the next job to be taken by the pool. */
+        size_t jobs_next;
+        /* Number of jobs not finished yet. */
+        size_t jobs_pending;
+        pthread_mutex_t jobs_lock;
+        pthread_cond_t jobs_cond;
+        pthread_cond_t jobs_done_cond;
+        bool jobs_sync_initilized;
 };
 
 struct geonkick {
@@ -66,6 +144,9 @@ struct geonkick {
          */
         atomic_bool synthesis_on;
 
+        /* Sample rate of the audio host. */
+        atomic_int sample_rate;
+
 	/* Global worker for all synths. */
 	struct gkick_worker worker;
         pthread_mutex_t lock;
@@ -83,13 +164,35 @@ geonkick_worker_init(struct geonkick *kick);
 enum geonkick_error
 geonkick_worker_start(struct geonkick *kick);
 
+size_t
+geonkick_worker_default_threads(void);
+
+enum geonkick_error
+geonkick_worker_resize_pool(struct geonkick *kick, size_t number);
+
 void
 geonkick_worker_destroy(struct geonkick *kick);
 
 void*
 geonkick_worker_thread(void *arg);
 
+void*
+geonkick_worker_synthesis_thread(void *arg);
+
+void
+geonkick_worker_process_jobs(struct geonkick *kick);
+
 void
 geonkick_worker_wakeup(struct geonkick *kick);
 
+void
+geonkick_sample_rate_changed(void *arg, int rate);
+
+void
+geonkick_worker_debounce(struct geonkick *kick);
+
+long long
+geonkick_worker_elapsed(const struct timespec *from,
+                        const struct timespec *to);
+
 #endif // GEONKICK_INTERNAL_H
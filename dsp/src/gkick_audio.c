@@ -57,6 +57,7 @@ gkick_audio_create(struct gkick_audio** audio)
 		return GEONKICK_ERROR;
 	}
 	(*audio)->mixer->audio_outputs = (*audio)->audio_outputs;
+        gkick_mixer_update_routing((*audio)->mixer);
 
 #ifdef GEONKICK_AUDIO_JACK
         if (gkick_create_jack(&(*audio)->jack, (*audio)->mixer) != GEONKICK_OK)
@@ -114,10 +115,34 @@ gkick_audio_play(struct gkick_audio *audio,
         }
 
         if (id < GEONKICK_MAX_PERCUSSIONS && audio->audio_outputs[id]->enabled)
-                gkick_audio_output_play(audio->audio_outputs[id]);
+                gkick_mixer_play(audio->mixer, id);
         return GEONKICK_OK;
 }
 
+enum geonkick_error
+gkick_audio_enable_output(struct gkick_audio *audio,
+                          size_t id,
+                          bool enable)
+{
+        if (audio == NULL) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+        return gkick_mixer_enable_output(audio->mixer, id, enable);
+}
+
+enum geonkick_error
+gkick_audio_set_output_channel(struct gkick_audio *audio,
+                               size_t id,
+                               size_t channel)
+{
+        if (audio == NULL) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+        return gkick_mixer_set_output_channel(audio->mixer, id, channel);
+}
+
 enum geonkick_error
 gkick_audio_key_pressed(struct gkick_audio *audio,
                         bool pressed,
@@ -150,6 +175,53 @@ gkick_audio_get_frame(struct gkick_audio *audio,
         return gkick_mixer_get_frame(audio->mixer, channel, val);
 }
 
+/**
+ * Renders the frames from the offset in segments between
+ * the note events, the events are applied at their offsets.
+ */
+enum geonkick_error
+gkick_audio_render_block(struct gkick_audio *audio,
+                         float **channels,
+                         size_t nchannels,
+                         size_t offset,
+                         size_t nframes,
+                         const struct gkick_note_event *events,
+                         size_t nevents)
+{
+        if (audio == NULL) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+
+        size_t frame = offset;
+        size_t last_frame = offset + nframes;
+        for (size_t i = 0; i <= nevents; i++) {
+                size_t end = last_frame;
+                if (i < nevents && events[i].offset < frame) {
+                        gkick_log_error("note events are not sorted by offset");
+                        end = frame;
+                } else if (i < nevents && events[i].offset < last_frame) {
+                        end = events[i].offset;
+                }
+
+                if (end > frame) {
+                        gkick_mixer_render(audio->mixer, channels, nchannels,
+                                           frame, end - frame);
+                        frame = end;
+                }
+
+                if (i < nevents && (events[i].state == GKICK_KEY_STATE_PRESSED
+                                    || events[i].state == GKICK_KEY_STATE_RELEASED)) {
+                        gkick_audio_key_pressed(audio,
+                                                events[i].state == GKICK_KEY_STATE_PRESSED,
+                                                events[i].note,
+                                                events[i].velocity);
+                }
+        }
+
+        return GEONKICK_OK;
+}
+
 enum geonkick_error
 gkick_audio_set_limiter_callback(struct gkick_audio *audio,
                                  void (*callback)(void*, gkick_real val),
@@ -159,3 +231,42 @@ gkick_audio_set_limiter_callback(struct gkick_audio *audio,
                                                 callback,
                                                 arg);
 }
+
+/**
+ * Returns the sample rate of the audio server, or 0
+ * if the sample rate is provided by the plugin host.
+ */
+int
+gkick_audio_get_sample_rate(struct gkick_audio *audio)
+{
+        if (audio == NULL) {
+                gkick_log_error("wrong arguments");
+                return 0;
+        }
+
+#ifdef GEONKICK_AUDIO_JACK
+        if (audio->jack != NULL)
+                return gkick_jack_sample_rate(audio->jack);
+#endif // GEONKICK_AUDIO_JACK
+        return 0;
+}
+
+enum geonkick_error
+gkick_audio_set_sample_rate_callback(struct gkick_audio *audio,
+                                     void (*callback)(void*, int rate),
+                                     void *arg)
+{
+        if (audio == NULL) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+
+#ifdef GEONKICK_AUDIO_JACK
+        if (audio->jack != NULL)
+                gkick_jack_set_sample_rate_callback(audio->jack, callback, arg);
+#else
+        GEONKICK_UNUSED(callback);
+        GEONKICK_UNUSED(arg);
+#endif // GEONKICK_AUDIO_JACK
+        return GEONKICK_OK;
+}
@@ -55,6 +55,16 @@ enum geonkick_error
 gkick_audio_play(struct gkick_audio *audio,
                  size_t id);
 
+enum geonkick_error
+gkick_audio_enable_output(struct gkick_audio *audio,
+                          size_t id,
+                          bool enable);
+
+enum geonkick_error
+gkick_audio_set_output_channel(struct gkick_audio *audio,
+                               size_t id,
+                               size_t channel);
+
 enum geonkick_error
 gkick_audio_key_pressed(struct gkick_audio *audio,
                         bool pressed,
@@ -66,9 +76,26 @@ gkick_audio_get_frame(struct gkick_audio *audio,
                       int channel,
                       gkick_real *val);
 
+enum geonkick_error
+gkick_audio_render_block(struct gkick_audio *audio,
+                         float **channels,
+                         size_t nchannels,
+                         size_t offset,
+                         size_t nframes,
+                         const struct gkick_note_event *events,
+                         size_t nevents);
+
 enum geonkick_error
 gkick_audio_set_limiter_callback(struct gkick_audio *audio,
                                  void (*callback)(void*, gkick_real val),
                                  void *arg);
 
+int
+gkick_audio_get_sample_rate(struct gkick_audio *audio);
+
+enum geonkick_error
+gkick_audio_set_sample_rate_callback(struct gkick_audio *audio,
+                                     void (*callback)(void*, int rate),
+                                     void *arg);
+
 #endif // GKICK_AUDIO_H
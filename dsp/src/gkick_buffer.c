@@ -40,6 +40,7 @@ gkick_buffer_new(struct gkick_buffer **buffer, int size)
         (*buffer)->size = (*buffer)->max_size;
         (*buffer)->currentIndex = 0;
         (*buffer)->floatIndex = 0.0f;
+        (*buffer)->committed = (*buffer)->max_size;
 
         (*buffer)->buff = (gkick_real*)malloc(sizeof(gkick_real) * (*buffer)->max_size);
         if ((*buffer)->buff == NULL) {
@@ -79,6 +80,7 @@ gkick_buffer_set_data(struct gkick_buffer *buffer,
                 size = buffer->max_size;
         memcpy(buffer->buff, data, sizeof(gkick_real) * size);
         buffer->size = size;
+        buffer->committed = size;
 
         buffer->currentIndex = 0;
         buffer->floatIndex = 0.0f;
@@ -175,3 +177,27 @@ gkick_buffer_is_end(struct gkick_buffer *buffer)
 {
         return (buffer->size < 1) || (buffer->currentIndex > buffer->size - 1);
 }
+
+/**
+ * Sets the number of frames from the beginning of the buffer that
+ * are written. The frames must be written before the commit.
+ */
+void
+gkick_buffer_commit(struct gkick_buffer *buffer,
+                    size_t frames)
+{
+        atomic_store_explicit(&buffer->committed, frames, memory_order_release);
+}
+
+/**
+ * Checks if the frames at the current position, including
+ * the next one used for interpolation, are committed.
+ */
+bool
+gkick_buffer_is_committed(struct gkick_buffer *buffer)
+{
+        size_t committed = atomic_load_explicit(&buffer->committed,
+                                                memory_order_acquire);
+        return committed >= buffer->size
+                || buffer->currentIndex + 1 < committed;
+}
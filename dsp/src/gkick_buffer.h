@@ -26,6 +26,8 @@
 
 #include "geonkick_internal.h"
 
+#include <stdatomic.h>
+
 struct gkick_buffer {
         gkick_real *buff;
 
@@ -46,6 +48,13 @@ struct gkick_buffer {
          * the life-time of the buffer.
          */
         size_t size;
+
+        /**
+         * Number of frames from the beginning of the buffer
+         * that are written and can be read. Allows reading
+         * the buffer while it is being written by another thread.
+         */
+        atomic_size_t committed;
 };
 
 void
@@ -95,4 +104,11 @@ gkick_buffer_push_back(struct gkick_buffer *buffer,
 bool
 gkick_buffer_is_end(struct gkick_buffer *buffer);
 
+void
+gkick_buffer_commit(struct gkick_buffer *buffer,
+                    size_t frames);
+
+bool
+gkick_buffer_is_committed(struct gkick_buffer *buffer);
+
 #endif // GKICK_BUFFER_H
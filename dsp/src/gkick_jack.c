@@ -42,8 +42,10 @@ gkick_jack_process_callback(jack_nframes_t nframes,
         if (events_count > 0)
                 jack_midi_event_get(&event, port_buf, event_index);
 
-        for (size_t i = 0; i < nframes; i++) {
-                while (event.time == i && event_index < events_count) {
+        /* Render the frames between the MIDI events in blocks. */
+        size_t frame = 0;
+        while (frame < nframes) {
+                while (event_index < events_count && event.time <= frame) {
 			struct gkick_note_info note;
                         memset(&note, 0, sizeof(struct gkick_note_info));
                         gkick_jack_get_note_info(&event, &note);
@@ -56,12 +58,18 @@ gkick_jack_process_callback(jack_nframes_t nframes,
                                 jack_midi_event_get(&event, port_buf, event_index);
                 }
 
-		gkick_real val;
-                gkick_mixer_get_frame(jack->mixer, 0, &val);
-                val *= 0.1f;
+                size_t end = nframes;
+                if (event_index < events_count && event.time < nframes)
+                        end = event.time;
+                gkick_mixer_render(jack->mixer, &buffer, 1, frame, end - frame);
+                frame = end;
+        }
+
+        for (size_t i = 0; i < nframes; i++) {
+                jack_default_audio_sample_t val = 0.1f * buffer[i];
                 if (val > 0.1f)
                         val = 0.1f;
-                buffer[i] = (jack_default_audio_sample_t)val;
+                buffer[i] = val;
         }
 
         return 0;
@@ -140,12 +148,41 @@ gkick_jack_get_midi_in_port(struct gkick_jack *jack)
         return port;
 }
 
+/**
+ * Called by the jack server (not from the process thread)
+ * when the sample rate of the server changes.
+ */
 int gkick_jack_srate_callback(jack_nframes_t nframes,
                               void *arg)
 {
+        struct gkick_jack *jack = (struct gkick_jack*)arg;
+        gkick_jack_lock(jack);
+        jack->sample_rate = nframes;
+        void (*callback)(void*, int) = jack->sample_rate_callback;
+        void *callback_arg = jack->sample_rate_callback_arg;
+        gkick_jack_unlock(jack);
+
+        if (callback != NULL && callback_arg != NULL)
+                callback(callback_arg, nframes);
 	return 0;
 }
 
+void
+gkick_jack_set_sample_rate_callback(struct gkick_jack *jack,
+                                    void (*callback)(void*, int rate),
+                                    void *arg)
+{
+        if (jack == NULL) {
+                gkick_log_error("wrong arguments");
+                return;
+        }
+
+        gkick_jack_lock(jack);
+        jack->sample_rate_callback = callback;
+        jack->sample_rate_callback_arg = arg;
+        gkick_jack_unlock(jack);
+}
+
 enum geonkick_error
 gkick_jack_enable_midi_in(struct gkick_jack *jack,
                           const char *name)
@@ -219,7 +256,7 @@ gkick_create_jack(struct gkick_jack **jack,
         *jack = (struct gkick_jack*)calloc(1, sizeof(struct gkick_jack));
         if (*jack == NULL)
                 return GEONKICK_ERROR;
-        (*jack)->sample_rate = GEONKICK_SAMPLE_RATE;
+        (*jack)->sample_rate = GEONKICK_DEFAULT_SAMPLE_RATE;
 
         if (pthread_mutex_init(&(*jack)->lock, NULL) != 0) {
                 gkick_log_error("error on init mutex");
@@ -239,6 +276,10 @@ gkick_create_jack(struct gkick_jack **jack,
         jack_set_process_callback((*jack)->client,
                                   gkick_jack_process_callback,
                                   (void*)(*jack));
+        (*jack)->sample_rate = jack_get_sample_rate((*jack)->client);
+        jack_set_sample_rate_callback((*jack)->client,
+                                      gkick_jack_srate_callback,
+                                      (void*)(*jack));
 
         if (gkick_jack_create_output_ports(*jack) != GEONKICK_OK) {
                 gkick_log_error("can't create output ports");
@@ -35,6 +35,9 @@ struct gkick_jack {
         jack_port_t *midi_in_port;
         jack_client_t *client;
         jack_nframes_t sample_rate;
+        /* Called when the sample rate of the server changes. */
+        void (*sample_rate_callback)(void*, int rate);
+        void *sample_rate_callback_arg;
         struct gkick_mixer *mixer;
         pthread_mutex_t lock;
 };
@@ -60,6 +63,11 @@ gkick_jack_get_midi_in_port(struct gkick_jack *jack);
 int gkick_jack_srate_callback(jack_nframes_t nframes,
                               void *arg);
 
+void
+gkick_jack_set_sample_rate_callback(struct gkick_jack *jack,
+                                    void (*callback)(void*, int rate),
+                                    void *arg);
+
 enum geonkick_error
 gkick_jack_enable_midi_in(struct gkick_jack *jack,
                           const char *name);
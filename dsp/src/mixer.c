@@ -32,6 +32,13 @@ gkick_mixer_create(struct gkick_mixer **mixer)
 		return GEONKICK_ERROR_MEM_ALLOC;
 	}
 
+        if (pthread_mutex_init(&(*mixer)->lock, NULL) != 0) {
+                gkick_log_error("error on init mutex");
+                free(*mixer);
+                *mixer = NULL;
+                return GEONKICK_ERROR;
+	}
+
 	return GEONKICK_OK;
 }
 
@@ -48,11 +55,113 @@ gkick_mixer_key_pressed(struct gkick_mixer *mixer,
                     || output->playing_key == note->note_number
 		    || output->tune)) {
                         gkick_audio_output_key_pressed(output, note);
+                        if (note->state == GKICK_KEY_STATE_PRESSED)
+                                mixer->voices |= (uint32_t)1 << i;
                 }
         }
 	return GEONKICK_OK;
 }
 
+/* Requests the output to play, can be called from any thread. */
+enum geonkick_error
+gkick_mixer_play(struct gkick_mixer *mixer,
+                 size_t index)
+{
+        if (index >= GEONKICK_MAX_PERCUSSIONS) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+
+        gkick_audio_output_play(mixer->audio_outputs[index]);
+        atomic_fetch_or(&mixer->play_requests, (uint32_t)1 << index);
+        return GEONKICK_OK;
+}
+
+enum geonkick_error
+gkick_mixer_enable_output(struct gkick_mixer *mixer,
+                          size_t index,
+                          bool enable)
+{
+        if (index >= GEONKICK_MAX_PERCUSSIONS) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+
+        mixer->audio_outputs[index]->enabled = enable;
+        gkick_mixer_update_routing(mixer);
+        return GEONKICK_OK;
+}
+
+enum geonkick_error
+gkick_mixer_set_output_channel(struct gkick_mixer *mixer,
+                               size_t index,
+                               size_t channel)
+{
+        if (index >= GEONKICK_MAX_PERCUSSIONS || channel >= GEONKICK_MAX_CHANNELS) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+
+        gkick_audio_output_set_channel(mixer->audio_outputs[index], channel);
+        gkick_mixer_update_routing(mixer);
+        return GEONKICK_OK;
+}
+
+/**
+ * Rebuilds the routing from the enabled state and
+ * the channel of the outputs and publishes it.
+ * Must not be called from the audio thread.
+ */
+void
+gkick_mixer_update_routing(struct gkick_mixer *mixer)
+{
+        struct gkick_mixer_routing routing;
+        memset(&routing, 0, sizeof(routing));
+        pthread_mutex_lock(&mixer->lock);
+        for (size_t i = 0; i < GEONKICK_MAX_PERCUSSIONS; i++) {
+                struct gkick_audio_output *out = mixer->audio_outputs[i];
+                size_t channel = out->channel;
+                if (!out->enabled || channel >= GEONKICK_MAX_CHANNELS)
+                        continue;
+                routing.channel_outputs[channel] |= (uint32_t)1 << i;
+                routing.enabled_outputs |= (uint32_t)1 << i;
+        }
+
+        unsigned int seq = atomic_load_explicit(&mixer->routing_seq, memory_order_relaxed);
+        atomic_store_explicit(&mixer->routing_seq, seq + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        for (size_t ch = 0; ch < GEONKICK_MAX_CHANNELS; ch++)
+                atomic_store_explicit(&mixer->routing_channel_outputs[ch],
+                                      routing.channel_outputs[ch],
+                                      memory_order_relaxed);
+        atomic_store_explicit(&mixer->routing_enabled_outputs,
+                              routing.enabled_outputs,
+                              memory_order_relaxed);
+        atomic_store_explicit(&mixer->routing_seq, seq + 2, memory_order_release);
+        pthread_mutex_unlock(&mixer->lock);
+}
+
+/**
+ * Reads the published routing without the lock.
+ * Retries while the routing is being updated.
+ */
+void
+gkick_mixer_get_routing(struct gkick_mixer *mixer,
+                        struct gkick_mixer_routing *routing)
+{
+        unsigned int seq;
+        do {
+                seq = atomic_load_explicit(&mixer->routing_seq, memory_order_acquire);
+                for (size_t ch = 0; ch < GEONKICK_MAX_CHANNELS; ch++)
+                        routing->channel_outputs[ch] = atomic_load_explicit(&mixer->routing_channel_outputs[ch],
+                                                                            memory_order_relaxed);
+                routing->enabled_outputs = atomic_load_explicit(&mixer->routing_enabled_outputs,
+                                                                memory_order_relaxed);
+                atomic_thread_fence(memory_order_acquire);
+        } while ((seq & 1)
+                 || seq != atomic_load_explicit(&mixer->routing_seq, memory_order_relaxed));
+}
+
 enum geonkick_error
 gkick_mixer_tune_output(struct gkick_mixer *mixer,
                         size_t index,
@@ -80,15 +189,91 @@ gkick_mixer_get_frame(struct gkick_mixer *mixer,
 		      gkick_real *val)
 {
         *val = 0.0f;
-        for (size_t i = 0; i < GEONKICK_MAX_PERCUSSIONS; i++) {
-                struct gkick_audio_output *out = mixer->audio_outputs[i];
-                if (out->enabled  && (out->channel == channel || GKICK_IS_STANDALONE)) {
-                        gkick_real v = 0.0f;
-                        gkick_audio_output_get_frame(out, &v);
-                        if (i == mixer->limiter_callback_index)
-                                gkick_mixer_set_leveler(mixer, v);
-                        *val += v;
+        if (channel < 0 || channel >= GEONKICK_MAX_CHANNELS)
+                return GEONKICK_OK;
+
+        struct gkick_mixer_routing routing;
+        gkick_mixer_get_routing(mixer, &routing);
+        uint32_t outputs = GKICK_IS_STANDALONE ? routing.enabled_outputs
+                : routing.channel_outputs[channel];
+        for (size_t i = 0; outputs != 0; i++, outputs >>= 1) {
+                if (!(outputs & 1))
+                        continue;
+                gkick_real v = 0.0f;
+                gkick_audio_output_get_frame(mixer->audio_outputs[i], &v);
+                if (i == mixer->limiter_callback_index)
+                        gkick_mixer_set_leveler(mixer, v);
+                *val += v;
+        }
+
+        return GEONKICK_OK;
+}
+
+/**
+ * Renders the frames from offset to offset + size of the channels.
+ *
+ * Only the sounding outputs routed to the given channels are
+ * rendered, each once per chunk, and added to their channel.
+ * The outputs of the channels that are not given are not advanced,
+ * as with gkick_mixer_get_frame. If no output is sounding only the
+ * channel buffers are cleared.
+ */
+enum geonkick_error
+gkick_mixer_render(struct gkick_mixer *mixer,
+                   float **channels,
+                   size_t nchannels,
+                   size_t offset,
+                   size_t size)
+{
+        _Alignas(GKICK_SYNTH_BUFFER_ALIGNMENT) gkick_real block[GKICK_MIXER_BLOCK_SIZE];
+        struct gkick_mixer_routing routing;
+        gkick_mixer_get_routing(mixer, &routing);
+        if (nchannels > GEONKICK_MAX_CHANNELS)
+                nchannels = GEONKICK_MAX_CHANNELS;
+
+        uint32_t routed = 0;
+        for (size_t ch = 0; ch < nchannels; ch++) {
+                if (channels[ch] == NULL)
+                        continue;
+                memset(channels[ch] + offset, 0, size * sizeof(float));
+                routed |= GKICK_IS_STANDALONE ? routing.enabled_outputs
+                        : routing.channel_outputs[ch];
+        }
+
+        mixer->voices |= atomic_exchange(&mixer->play_requests, 0);
+        size_t leveler_index = mixer->limiter_callback_index;
+        for (size_t start = 0; start < size; start += GKICK_MIXER_BLOCK_SIZE) {
+                size_t n = size - start;
+                if (n > GKICK_MIXER_BLOCK_SIZE)
+                        n = GKICK_MIXER_BLOCK_SIZE;
+
+                gkick_real leveler = 0.0f;
+                uint32_t outputs = mixer->voices & routed;
+                for (size_t i = 0; outputs != 0; i++, outputs >>= 1) {
+                        if (!(outputs & 1))
+                                continue;
+
+                        struct gkick_audio_output *out = mixer->audio_outputs[i];
+                        gkick_audio_output_render(out, block, n);
+                        if (!out->is_play)
+                                mixer->voices &= ~((uint32_t)1 << i);
+                        if (i == leveler_index)
+                                leveler = block[n - 1];
+
+                        for (size_t ch = 0; ch < nchannels; ch++) {
+                                if (channels[ch] == NULL
+                                    || (!GKICK_IS_STANDALONE
+                                        && !(routing.channel_outputs[ch] & ((uint32_t)1 << i))))
+                                        continue;
+                                float *dst = channels[ch] + offset + start;
+                                for (size_t j = 0; j < n; j++)
+                                        dst[j] += (float)block[j];
+                        }
                 }
+
+                if (leveler_index < GEONKICK_MAX_PERCUSSIONS
+                    && (routed & ((uint32_t)1 << leveler_index)))
+                        gkick_mixer_set_leveler(mixer, leveler);
         }
 
         return GEONKICK_OK;
@@ -106,6 +291,7 @@ void
 gkick_mixer_free(struct gkick_mixer **mixer)
 {
 	if (mixer != NULL && *mixer != NULL) {
+                pthread_mutex_destroy(&(*mixer)->lock);
 		free(*mixer);
 		*mixer = NULL;
 	}
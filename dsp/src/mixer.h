@@ -26,6 +26,17 @@
 
 #include "audio_output.h"
 
+/* Size of the chunks the mixer renders the outputs in. */
+#define GKICK_MIXER_BLOCK_SIZE 256
+
+/* Routing of the enabled outputs to the channels. */
+struct gkick_mixer_routing {
+        /* Bit mask of the enabled outputs routed to the channel. */
+        uint32_t channel_outputs[GEONKICK_MAX_CHANNELS];
+        /* Bit mask of all the enabled outputs. */
+        uint32_t enabled_outputs;
+};
+
 struct gkick_mixer {
 	struct gkick_audio_output **audio_outputs;
 	size_t connection_matrix[127];
@@ -33,6 +44,27 @@ struct gkick_mixer {
         void (*limiter_callback) (void*, gkick_real val);
         void *limiter_callback_arg;
         _Atomic size_t limiter_callback_index;
+
+        /**
+         * The routing is built by gkick_mixer_update_routing outside
+         * of the audio thread when the channel of an output or its
+         * enabled state changes. It is published under a sequence
+         * counter that is odd during the update.
+         */
+        atomic_uint routing_seq;
+        _Atomic uint32_t routing_channel_outputs[GEONKICK_MAX_CHANNELS];
+        _Atomic uint32_t routing_enabled_outputs;
+
+        /* Bit mask of the outputs requested to play by gkick_mixer_play. */
+        _Atomic uint32_t play_requests;
+
+        /**
+         * Bit mask of the sounding outputs.
+         * Used only by the audio thread.
+         */
+        uint32_t voices;
+
+        pthread_mutex_t lock;
 };
 
 enum geonkick_error
@@ -42,6 +74,27 @@ enum geonkick_error
 gkick_mixer_key_pressed(struct gkick_mixer *mixer,
 			struct gkick_note_info *note);
 
+enum geonkick_error
+gkick_mixer_play(struct gkick_mixer *mixer,
+                 size_t index);
+
+enum geonkick_error
+gkick_mixer_enable_output(struct gkick_mixer *mixer,
+                          size_t index,
+                          bool enable);
+
+enum geonkick_error
+gkick_mixer_set_output_channel(struct gkick_mixer *mixer,
+                               size_t index,
+                               size_t channel);
+
+void
+gkick_mixer_update_routing(struct gkick_mixer *mixer);
+
+void
+gkick_mixer_get_routing(struct gkick_mixer *mixer,
+                        struct gkick_mixer_routing *routing);
+
 enum geonkick_error
 gkick_mixer_tune_output(struct gkick_mixer *mixer,
                         size_t index,
@@ -57,6 +110,13 @@ gkick_mixer_get_frame(struct gkick_mixer *mixer,
 		      int channel,
 		      gkick_real *val);
 
+enum geonkick_error
+gkick_mixer_render(struct gkick_mixer *mixer,
+                   float **channels,
+                   size_t nchannels,
+                   size_t offset,
+                   size_t size);
+
 void
 gkick_mixer_set_leveler(struct gkick_mixer *mixer,
                              gkick_real val);
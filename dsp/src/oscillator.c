@@ -35,16 +35,12 @@ struct gkick_oscillator
         osc->state = GEONKICK_OSC_STATE_ENABLED;
         osc->func = GEONKICK_OSC_FUNC_SINE;
         osc->initial_phase = 0.0f;
-        osc->phase = osc->initial_phase;
-        osc->sample_rate = GEONKICK_SAMPLE_RATE;
+        osc->sample_rate = GEONKICK_DEFAULT_SAMPLE_RATE;
         osc->amplitude = GKICK_OSC_DEFAULT_AMPLITUDE;
         osc->frequency = GKICK_OSC_DEFAULT_FREQUENCY;
         osc->env_number = 2;
-        osc->brownian = 0;
         osc->is_fm = false;
-        osc->fm_input = 0.0f;
         osc->seed = 100;
-        osc->seedp = osc->seed;
 
         if (gkick_osc_create_envelopes(osc) != GEONKICK_OK) {
                 gkick_osc_free(&osc);
@@ -79,6 +75,108 @@ gkick_osc_free(struct gkick_oscillator **osc)
         *osc = NULL;
 }
 
+/**
+ * Copies the oscillator parameters, envelopes, filter and sample.
+ * The oscillator state (phase, FM input, etc.) of the destination
+ * is not changed.
+ */
+enum geonkick_error
+gkick_osc_copy(struct gkick_oscillator *dst,
+               struct gkick_oscillator *src)
+{
+        if (dst == NULL || src == NULL) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+
+        dst->state          = src->state;
+        dst->func           = src->func;
+        dst->seed           = src->seed;
+        dst->initial_phase  = src->initial_phase;
+        dst->sample_rate    = src->sample_rate;
+        dst->frequency      = src->frequency;
+        dst->amplitude      = src->amplitude;
+        dst->is_fm          = src->is_fm;
+        dst->band_limited   = src->band_limited;
+        dst->filter_enabled = src->filter_enabled;
+        for (size_t i = 0; i < dst->env_number && i < src->env_number; i++)
+                gkick_envelope_copy(dst->envelopes[i], src->envelopes[i]);
+        gkick_filter_copy(dst->filter, src->filter);
+
+        /* The sample is copied only when it is used. */
+        if (src->func == GEONKICK_OSC_FUNC_SAMPLE && src->sample != NULL) {
+                if (dst->sample != NULL && dst->sample->max_size < src->sample->max_size)
+                        gkick_buffer_free(&dst->sample);
+                if (dst->sample == NULL)
+                        gkick_buffer_new(&dst->sample, src->sample->max_size);
+                if (dst->sample == NULL)
+                        return GEONKICK_ERROR_MEM_ALLOC;
+                gkick_buffer_set_size(dst->sample, 0);
+                gkick_buffer_set_data(dst->sample,
+                                      src->sample->buff,
+                                      gkick_buffer_size(src->sample));
+        } else if (dst->sample != NULL) {
+                gkick_buffer_free(&dst->sample);
+        }
+
+        return GEONKICK_OK;
+}
+
+/**
+ * Sets the sample rate of the oscillator and its filter. The sample
+ * of the oscillator is resampled to keep its pitch and length.
+ */
+void
+gkick_osc_set_sample_rate(struct gkick_oscillator *osc,
+                          gkick_real rate)
+{
+        if (osc->sample != NULL && osc->sample_rate != rate
+            && gkick_osc_resample_sample(osc, rate) != GEONKICK_OK)
+                gkick_log_error("can't resample the oscillator sample");
+        osc->sample_rate = rate;
+        gkick_filter_set_sample_rate(osc->filter, rate);
+}
+
+/**
+ * Resamples the sample of the oscillator from the oscillator
+ * sample rate to the rate with the linear interpolation.
+ */
+enum geonkick_error
+gkick_osc_resample_sample(struct gkick_oscillator *osc,
+                          gkick_real rate)
+{
+        struct gkick_buffer *sample = NULL;
+        gkick_buffer_new(&sample, GEONKICK_MAX_LENGTH * rate);
+        if (sample == NULL)
+                return GEONKICK_ERROR_MEM_ALLOC;
+
+        double factor = (double)osc->sample_rate / rate;
+        size_t src_size = gkick_buffer_size(osc->sample);
+        size_t size = 0;
+        if (src_size > 0)
+                size = (size_t)((src_size - 1) / factor) + 1;
+        if (size > sample->max_size)
+                size = sample->max_size;
+
+        const gkick_real *src = osc->sample->buff;
+        for (size_t i = 0; i < size; i++) {
+                double x = i * factor;
+                size_t j = (size_t)x;
+                gkick_real val = src[j];
+                if (j + 1 < src_size) {
+                        gkick_real d = (gkick_real)(x - j);
+                        val = src[j] * (1.0f - d) + src[j + 1] * d;
+                }
+                sample->buff[i] = val;
+        }
+        gkick_buffer_set_size(sample, size);
+        gkick_buffer_commit(sample, size);
+
+        gkick_buffer_free(&osc->sample);
+        osc->sample = sample;
+        return GEONKICK_OK;
+}
+
 void
 gkick_osc_set_state(struct gkick_oscillator *osc,
                          enum geonkick_osc_state state)
@@ -124,125 +222,483 @@ gkick_osc_get_envelope(struct gkick_oscillator *osc,
         return NULL;
 }
 
-void gkick_osc_increment_phase(struct gkick_oscillator *osc,
-			       gkick_real t,
-			       gkick_real kick_len)
+/**
+ * Resets the synthesis state of the oscillator
+ * before the beginning of the synthesis.
+ */
+void
+gkick_osc_reset(struct gkick_oscillator *osc,
+                struct gkick_osc_state *state,
+                size_t index)
 {
-        gkick_real f;
-        f = osc->frequency * gkick_envelope_get_value(osc->envelopes[1], t / kick_len);
-        f += f * osc->fm_input;
-        osc->phase += (2.0f * M_PI * f) / (osc->sample_rate);
-        if (osc->phase > 2.0f * M_PI)
-                osc->phase -= 2.0f * M_PI;
+        state->phase[index]     = (uint32_t)(int64_t)(osc->initial_phase / (2.0f * M_PI)
+                                                  * GKICK_OSC_PHASE_PERIOD);
+        state->frequency[index] = osc->frequency;
+        state->amplitude[index] = osc->amplitude;
+        state->noise_key[index] = gkick_osc_noise_hash(osc->seed);
+        state->brownian[index]  = 0.0f;
+        gkick_osc_pink_reset(state->noise_key[index],
+                             state->pink_rows[index],
+                             &state->pink_sum[index]);
+        gkick_envelope_cursor_reset(&state->amplitude_cursor[index]);
+        gkick_envelope_cursor_reset(&state->frequency_cursor[index]);
+        gkick_envelope_cursor_reset(&state->cutoff_cursor[index]);
+        gkick_filter_init(osc->filter);
+        if (osc->sample != NULL)
+                gkick_buffer_reset(osc->sample);
 }
 
-gkick_real gkick_osc_value(struct gkick_oscillator *osc,
-		       gkick_real t,
-		       gkick_real kick_len)
+/**
+ * Renders a block of the oscillator signal into the out buffer.
+ *
+ * The block is rendered in chunks. For every chunk, first the phase
+ * and the amplitude of every frame are calculated from the envelopes,
+ * then the waveform is evaluated for the whole chunk.
+ *
+ * @param offset index of the first frame of the block
+ *               from the beginning of the percussion.
+ * @param fm     signal of the FM source oscillator for the block,
+ *               NULL if the oscillator is not frequency modulated.
+ */
+void
+gkick_osc_render(struct gkick_oscillator *osc,
+                 struct gkick_osc_state *state,
+                 size_t index,
+                 const gkick_real *fm,
+                 gkick_real *out,
+                 size_t offset,
+                 size_t size,
+                 gkick_real dt,
+                 gkick_real kick_len)
 {
-        gkick_real amp;
-        gkick_real v;
-        gkick_real env_x;
-
-        // Caluclate the x corrdinate between 0 and 1.0 for the envelope.
-        env_x = t / kick_len;
-        amp = osc->amplitude * gkick_envelope_get_value(osc->envelopes[0], env_x);
-        v = 0.0f;
-        switch (osc->func) {
-        case GEONKICK_OSC_FUNC_SINE:
-                v = amp * gkick_osc_func_sine(osc->phase);
-                break;
-        case GEONKICK_OSC_FUNC_SQUARE:
-                v = amp * gkick_osc_func_square(osc->phase);
-                break;
-        case GEONKICK_OSC_FUNC_TRIANGLE:
-                v = amp * gkick_osc_func_triangle(osc->phase);
-                break;
-        case GEONKICK_OSC_FUNC_SAWTOOTH:
-                v = amp * gkick_osc_func_sawtooth(osc->phase);
-                break;
-        case GEONKICK_OSC_FUNC_NOISE_WHITE:
-                v = amp * gkick_osc_func_noise_white(&osc->seedp);
-                break;
-        case GEONKICK_OSC_FUNC_NOISE_PINK:
-                v = amp * gkick_osc_func_noise_pink();
-                break;
-        case GEONKICK_OSC_FUNC_NOISE_BROWNIAN:
-                v = amp * gkick_osc_func_noise_brownian(&(osc)->brownian, &osc->seedp);
-                break;
-        case GEONKICK_OSC_FUNC_SAMPLE:
-                if (osc->sample != NULL) {
-                        if (t > (0.5f * osc->initial_phase / (2.0f * M_PI)) * kick_len)
-                                v = amp * gkick_osc_func_sample(osc->sample);
+        uint32_t phase       = state->phase[index];
+        gkick_real frequency = state->frequency[index];
+        gkick_real amplitude = state->amplitude[index];
+        uint32_t noise_key   = state->noise_key[index];
+        gkick_real brownian  = state->brownian[index];
+        /* Phase increment per 1 Hz. */
+        gkick_real phase_scale = GKICK_OSC_PHASE_PERIOD / osc->sample_rate;
+        /* Step of the envelopes x coordinate (between 0 and 1.0) per frame. */
+        gkick_real env_dx = dt / kick_len;
+
+        _Alignas(GKICK_SYNTH_BUFFER_ALIGNMENT) uint32_t phases[GKICK_OSC_BLOCK_SIZE];
+        _Alignas(GKICK_SYNTH_BUFFER_ALIGNMENT) uint32_t increments[GKICK_OSC_BLOCK_SIZE];
+        /* Envelope curves of the chunk. */
+        _Alignas(GKICK_SYNTH_BUFFER_ALIGNMENT) gkick_real amps[GKICK_OSC_BLOCK_SIZE];
+        _Alignas(GKICK_SYNTH_BUFFER_ALIGNMENT) gkick_real freqs[GKICK_OSC_BLOCK_SIZE];
+        _Alignas(GKICK_SYNTH_BUFFER_ALIGNMENT) gkick_real cutoffs[GKICK_OSC_BLOCK_SIZE];
+        for (size_t start = 0; start < size; start += GKICK_OSC_BLOCK_SIZE) {
+                size_t n = size - start;
+                if (n > GKICK_OSC_BLOCK_SIZE)
+                        n = GKICK_OSC_BLOCK_SIZE;
+                gkick_real *block_out = out + start;
+
+                gkick_envelope_render(osc->envelopes[0], &state->amplitude_cursor[index],
+                                      offset + start, env_dx, amps, n);
+                gkick_envelope_render(osc->envelopes[1], &state->frequency_cursor[index],
+                                      offset + start, env_dx, freqs, n);
+                for (size_t i = 0; i < n; i++) {
+                        amps[i] *= amplitude;
+                        phases[i] = phase;
+
+                        gkick_real f = frequency * freqs[i];
+                        if (fm != NULL)
+                                f += f * fm[start + i];
+                        increments[i] = (uint32_t)(int64_t)(f * phase_scale);
+                        phase += increments[i];
+                }
+
+                switch (osc->func) {
+                case GEONKICK_OSC_FUNC_SQUARE:
+                        if (osc->band_limited)
+                                gkick_osc_func_square_bl(phases, increments, amps, block_out, n);
+                        else
+                                gkick_osc_func_square(phases, amps, block_out, n);
+                        break;
+                case GEONKICK_OSC_FUNC_TRIANGLE:
+                        if (osc->band_limited)
+                                gkick_osc_func_triangle_bl(phases, increments, amps, block_out, n);
                         else
-                                v = 0.0f;
+                                gkick_osc_func_triangle(phases, amps, block_out, n);
+                        break;
+                case GEONKICK_OSC_FUNC_SAWTOOTH:
+                        if (osc->band_limited)
+                                gkick_osc_func_sawtooth_bl(phases, increments, amps, block_out, n);
+                        else
+                                gkick_osc_func_sawtooth(phases, amps, block_out, n);
+                        break;
+                case GEONKICK_OSC_FUNC_NOISE_WHITE:
+                        gkick_osc_func_noise_white(noise_key, (uint32_t)(offset + start),
+                                                   amps, block_out, n);
+                        break;
+                case GEONKICK_OSC_FUNC_NOISE_PINK:
+                        gkick_osc_func_noise_pink(noise_key, (uint32_t)(offset + start),
+                                                  state->pink_rows[index], &state->pink_sum[index],
+                                                  amps, block_out, n);
+                        break;
+                case GEONKICK_OSC_FUNC_NOISE_BROWNIAN:
+                        gkick_osc_func_noise_brownian(noise_key, (uint32_t)(offset + start),
+                                                      &brownian, amps, block_out, n);
+                        break;
+                case GEONKICK_OSC_FUNC_SAMPLE:
+                        for (size_t i = 0; i < n; i++) {
+                                gkick_real t = (gkick_real)((offset + start + i) * dt);
+                                block_out[i] = 0.0f;
+                                if (osc->sample != NULL
+                                    && t > (0.5f * osc->initial_phase / (2.0f * M_PI)) * kick_len)
+                                        block_out[i] = amps[i] * gkick_osc_func_sample(osc->sample);
+                        }
+                        break;
+                default:
+                        gkick_osc_func_sine(phases, amps, block_out, n);
+                };
+
+                if (osc->filter_enabled) {
+                        gkick_envelope_render(osc->filter->cutoff_env, &state->cutoff_cursor[index],
+                                              offset + start, env_dx, cutoffs, n);
+                        gkick_filter_process(osc->filter, block_out, block_out, n, cutoffs);
                 }
-                break;
-        default:
-                v = amp * gkick_osc_func_sine(osc->phase);
-        };
+        }
 
-        if (osc->filter_enabled)
-                gkick_filter_val(osc->filter, v, &v, env_x);
+        state->phase[index]    = phase;
+        state->brownian[index] = brownian;
+}
 
-        return v;
+/**
+ * Evaluates the sine for a block of phases.
+ *
+ * The phase is mapped to x in [-1, 1) (units of PI), folded into
+ * [-0.5, 0.5] using sin(PI - a) = sin(a), and the sine is approximated
+ * with its Taylor polynomial of degree 11 (error below 1e-7).
+ * There are no calls and no branches, so the loop can be vectorized.
+ */
+void
+gkick_osc_func_sine(const uint32_t *phase,
+                    const gkick_real *amp,
+                    gkick_real *out,
+                    size_t size)
+{
+        for (size_t i = 0; i < size; i++) {
+                gkick_real x = (gkick_real)(int32_t)phase[i] * (gkick_real)(1.0 / 2147483648.0);
+                if (x > 0.5f)
+                        x = 1.0f - x;
+                else if (x < -0.5f)
+                        x = -1.0f - x;
+                gkick_real y  = (gkick_real)M_PI * x;
+                gkick_real y2 = y * y;
+                gkick_real s = (gkick_real)(-1.0 / 39916800.0);
+                s = s * y2 + (gkick_real)(1.0 / 362880.0);
+                s = s * y2 + (gkick_real)(-1.0 / 5040.0);
+                s = s * y2 + (gkick_real)(1.0 / 120.0);
+                s = s * y2 + (gkick_real)(-1.0 / 6.0);
+                s = s * y2 + 1.0f;
+                out[i] = amp[i] * y * s;
+        }
 }
 
-gkick_real
-gkick_osc_func_sine(gkick_real phase)
+void
+gkick_osc_func_square(const uint32_t *phase,
+                      const gkick_real *amp,
+                      gkick_real *out,
+                      size_t size)
+{
+        for (size_t i = 0; i < size; i++)
+                out[i] = (phase[i] < 0x80000000u) ? -amp[i] : amp[i];
+}
+
+void
+gkick_osc_func_triangle(const uint32_t *phase,
+                        const gkick_real *amp,
+                        gkick_real *out,
+                        size_t size)
 {
-        return sin(phase);
+        for (size_t i = 0; i < size; i++) {
+                gkick_real u = (gkick_real)phase[i] * (gkick_real)(1.0 / GKICK_OSC_PHASE_PERIOD);
+                gkick_real v = (u < 0.5f) ? -1.0f + 4.0f * u : 3.0f - 4.0f * u;
+                out[i] = amp[i] * v;
+        }
 }
 
+void
+gkick_osc_func_sawtooth(const uint32_t *phase,
+                        const gkick_real *amp,
+                        gkick_real *out,
+                        size_t size)
+{
+        for (size_t i = 0; i < size; i++) {
+                gkick_real u = (gkick_real)phase[i] * (gkick_real)(1.0 / GKICK_OSC_PHASE_PERIOD);
+                out[i] = amp[i] * (1.0f - 2.0f * u);
+        }
+}
+
+/**
+ * PolyBLEP residual of a step discontinuity at the phase 0.
+ *
+ * @param t  phase as fraction of the period [0, 1).
+ * @param dt phase increment per frame as fraction of the period.
+ */
 gkick_real
-gkick_osc_func_square(gkick_real phase)
+gkick_osc_poly_blep(gkick_real t, gkick_real dt)
 {
-        if (phase < M_PI)
-                return -1.0f;
-        else
-                return 1.0f;
+        if (t < dt) {
+                gkick_real x = t / dt;
+                return x + x - x * x - 1.0f;
+        } else if (t > 1.0f - dt) {
+                gkick_real x = (t - 1.0f) / dt;
+                return x * x + x + x + 1.0f;
+        }
+        return 0.0f;
 }
 
+/**
+ * PolyBLAMP residual of a slope discontinuity at the phase 0,
+ * i.e. the integral of the PolyBLEP residual.
+ */
 gkick_real
-gkick_osc_func_triangle(gkick_real phase)
+gkick_osc_poly_blamp(gkick_real t, gkick_real dt)
 {
-	if (phase < M_PI)
-		return -1.0f + (2.0f / M_PI) * phase;
-	else
-		return 3.0f - (2.0f / M_PI) * phase;
+        if (t < dt) {
+                gkick_real x = t / dt - 1.0f;
+                return -x * x * x / 3.0f;
+        } else if (t > 1.0f - dt) {
+                gkick_real x = (t - 1.0f) / dt + 1.0f;
+                return x * x * x / 3.0f;
+        }
+        return 0.0f;
 }
 
+/**
+ * Returns the phase increment as fraction of the period, limited to
+ * the Nyquist frequency. Negative frequencies have the same step.
+ */
 gkick_real
-gkick_osc_func_sawtooth(gkick_real phase)
+gkick_osc_phase_step(uint32_t increment)
 {
-        return 1.0f - (1.0f / M_PI) * phase;
+        int32_t inc = (int32_t)increment;
+        gkick_real dt = (gkick_real)(inc < 0 ? -(int64_t)inc : inc)
+                * (gkick_real)(1.0 / GKICK_OSC_PHASE_PERIOD);
+        return dt > 0.5f ? 0.5f : dt;
 }
 
-gkick_real gkick_osc_func_noise_white(unsigned int *seed)
+/**
+ * Band-limited square. Every jump of the naive square is
+ * smoothed with the PolyBLEP residual.
+ */
+void
+gkick_osc_func_square_bl(const uint32_t *phase,
+                         const uint32_t *increment,
+                         const gkick_real *amp,
+                         gkick_real *out,
+                         size_t size)
 {
-        return 2.0f * ((gkick_real)(rand_r(seed) % RAND_MAX)) / RAND_MAX - 1.0f;
+        for (size_t i = 0; i < size; i++) {
+                gkick_real dt = gkick_osc_phase_step(increment[i]);
+                gkick_real u  = (gkick_real)phase[i] * (gkick_real)(1.0 / GKICK_OSC_PHASE_PERIOD);
+                gkick_real u2 = (gkick_real)(uint32_t)(phase[i] + 0x80000000u)
+                        * (gkick_real)(1.0 / GKICK_OSC_PHASE_PERIOD);
+                gkick_real v = (u < 0.5f) ? -1.0f : 1.0f;
+                v += gkick_osc_poly_blep(u2, dt) - gkick_osc_poly_blep(u, dt);
+                out[i] = amp[i] * v;
+        }
 }
 
-gkick_real gkick_osc_func_noise_pink(void)
+/**
+ * Band-limited triangle. The corners of the naive triangle are
+ * smoothed with the PolyBLAMP residual scaled by the slope change.
+ */
+void
+gkick_osc_func_triangle_bl(const uint32_t *phase,
+                           const uint32_t *increment,
+                           const gkick_real *amp,
+                           gkick_real *out,
+                           size_t size)
 {
-        return 0.0f;
+        for (size_t i = 0; i < size; i++) {
+                gkick_real dt = gkick_osc_phase_step(increment[i]);
+                gkick_real u  = (gkick_real)phase[i] * (gkick_real)(1.0 / GKICK_OSC_PHASE_PERIOD);
+                gkick_real u2 = (gkick_real)(uint32_t)(phase[i] + 0x80000000u)
+                        * (gkick_real)(1.0 / GKICK_OSC_PHASE_PERIOD);
+                gkick_real v = (u < 0.5f) ? -1.0f + 4.0f * u : 3.0f - 4.0f * u;
+                v += 4.0f * dt * (gkick_osc_poly_blamp(u, dt) - gkick_osc_poly_blamp(u2, dt));
+                out[i] = amp[i] * v;
+        }
 }
 
-gkick_real
-gkick_osc_func_noise_brownian(gkick_real *previous,
-                              unsigned int *seed)
+/**
+ * Band-limited sawtooth. The jump of the naive
+ * sawtooth is smoothed with the PolyBLEP residual.
+ */
+void
+gkick_osc_func_sawtooth_bl(const uint32_t *phase,
+                           const uint32_t *increment,
+                           const gkick_real *amp,
+                           gkick_real *out,
+                           size_t size)
+{
+        for (size_t i = 0; i < size; i++) {
+                gkick_real dt = gkick_osc_phase_step(increment[i]);
+                gkick_real u  = (gkick_real)phase[i] * (gkick_real)(1.0 / GKICK_OSC_PHASE_PERIOD);
+                out[i] = amp[i] * (1.0f - 2.0f * u + gkick_osc_poly_blep(u, dt));
+        }
+}
+
+/**
+ * Integer hash with a good avalanche (lowbias32 by C. Wellons).
+ */
+uint32_t
+gkick_osc_noise_hash(uint32_t x)
+{
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+}
+
+/**
+ * Counter-based pseudo random generator.
+ *
+ * Returns the random value for the frame counter of the stream
+ * identified by the key. The value depends only on the key
+ * and the counter, so the noise is the same for the same seed
+ * independently of how the percussion is rendered.
+ */
+uint32_t
+gkick_osc_noise_value(uint32_t key, uint32_t counter)
+{
+        return gkick_osc_noise_hash(gkick_osc_noise_hash(counter ^ key) + key);
+}
+
+/**
+ * Fills a block with the random values of the consecutive counters.
+ * There is no dependency between the frames, so the loop can be vectorized.
+ */
+void
+gkick_osc_noise_fill(uint32_t key,
+                     uint32_t counter,
+                     uint32_t *out,
+                     size_t size)
 {
-        gkick_real sign = 1.0f;
-        gkick_real walk;
-        if (rand_r(seed) % 2)
-                sign = -1.0f;
-
-        walk = sign * 0.1f * (((gkick_real)(rand_r(seed) % RAND_MAX)) / RAND_MAX);
-        if (*previous + walk > 1.0f || *previous + walk < -1.0f)
-                *previous -= walk;
-        else
-                *previous += walk;
-        return *previous;
+        for (size_t i = 0; i < size; i++)
+                out[i] = gkick_osc_noise_value(key, counter + (uint32_t)i);
+}
+
+void
+gkick_osc_func_noise_white(uint32_t key,
+                           uint32_t counter,
+                           const gkick_real *amp,
+                           gkick_real *out,
+                           size_t size)
+{
+        _Alignas(GKICK_SYNTH_BUFFER_ALIGNMENT) uint32_t values[GKICK_OSC_BLOCK_SIZE];
+        for (size_t start = 0; start < size; start += GKICK_OSC_BLOCK_SIZE) {
+                size_t n = size - start;
+                if (n > GKICK_OSC_BLOCK_SIZE)
+                        n = GKICK_OSC_BLOCK_SIZE;
+                gkick_osc_noise_fill(key, counter + (uint32_t)start, values, n);
+                for (size_t i = 0; i < n; i++)
+                        out[start + i] = amp[start + i] * (gkick_real)(int32_t)values[i]
+                                * (gkick_real)(1.0 / 2147483648.0);
+        }
+}
+
+/**
+ * Sets the initial random values of the pink noise rows.
+ */
+void
+gkick_osc_pink_reset(uint32_t key,
+                     int32_t *rows,
+                     int32_t *sum)
+{
+        *sum = 0;
+        for (size_t k = 0; k < GKICK_OSC_PINK_ROWS; k++) {
+                rows[k] = (int32_t)gkick_osc_noise_value(key + 2 * GKICK_OSC_NOISE_STREAM,
+                                                         (uint32_t)k) >> 5;
+                *sum += rows[k];
+        }
+}
+
+/**
+ * Pink noise with the Voss-McCartney algorithm.
+ *
+ * The output is the sum of the rows and a white noise value.
+ * At the frame n only the row with the index equal to the number
+ * of the trailing zeros of n is updated, so the row k changes every
+ * 2^(k + 1) frames. The rows are kept as integers with 5 bits
+ * of headroom, so the sum is exact and the output is in [-1, 1).
+ */
+void
+gkick_osc_func_noise_pink(uint32_t key,
+                          uint32_t counter,
+                          int32_t *rows,
+                          int32_t *sum,
+                          const gkick_real *amp,
+                          gkick_real *out,
+                          size_t size)
+{
+        _Alignas(GKICK_SYNTH_BUFFER_ALIGNMENT) uint32_t updates[GKICK_OSC_BLOCK_SIZE];
+        _Alignas(GKICK_SYNTH_BUFFER_ALIGNMENT) uint32_t values[GKICK_OSC_BLOCK_SIZE];
+        const gkick_real scale = (gkick_real)(1.0 / ((GKICK_OSC_PINK_ROWS + 1) * 67108864.0));
+        int32_t total = *sum;
+        for (size_t start = 0; start < size; start += GKICK_OSC_BLOCK_SIZE) {
+                size_t n = size - start;
+                if (n > GKICK_OSC_BLOCK_SIZE)
+                        n = GKICK_OSC_BLOCK_SIZE;
+                gkick_osc_noise_fill(key, counter + (uint32_t)start, updates, n);
+                gkick_osc_noise_fill(key + GKICK_OSC_NOISE_STREAM,
+                                     counter + (uint32_t)start, values, n);
+                for (size_t i = 0; i < n; i++) {
+                        uint32_t frame = counter + (uint32_t)(start + i);
+                        if (frame != 0) {
+                                size_t k = 0;
+                                while (!(frame & 1)) {
+                                        frame >>= 1;
+                                        k++;
+                                }
+                                if (k < GKICK_OSC_PINK_ROWS) {
+                                        int32_t row = (int32_t)updates[i] >> 5;
+                                        total += row - rows[k];
+                                        rows[k] = row;
+                                }
+                        }
+                        out[start + i] = amp[start + i] * scale
+                                * (gkick_real)(total + ((int32_t)values[i] >> 5));
+                }
+        }
+        *sum = total;
+}
+
+/**
+ * Brownian noise as a random walk of steps up to 0.1
+ * reflected back when it goes out of [-1, 1].
+ * The steps are generated for the whole block first,
+ * then integrated.
+ */
+void
+gkick_osc_func_noise_brownian(uint32_t key,
+                              uint32_t counter,
+                              gkick_real *previous,
+                              const gkick_real *amp,
+                              gkick_real *out,
+                              size_t size)
+{
+        _Alignas(GKICK_SYNTH_BUFFER_ALIGNMENT) uint32_t values[GKICK_OSC_BLOCK_SIZE];
+        gkick_real value = *previous;
+        for (size_t start = 0; start < size; start += GKICK_OSC_BLOCK_SIZE) {
+                size_t n = size - start;
+                if (n > GKICK_OSC_BLOCK_SIZE)
+                        n = GKICK_OSC_BLOCK_SIZE;
+                gkick_osc_noise_fill(key, counter + (uint32_t)start, values, n);
+                for (size_t i = 0; i < n; i++) {
+                        gkick_real walk = (gkick_real)(int32_t)values[i]
+                                * (gkick_real)(0.1 / 2147483648.0);
+                        gkick_real next = value + walk;
+                        value = (next > 1.0f || next < -1.0f) ? value - walk : next;
+                        out[start + i] = amp[start + i] * value;
+                }
+        }
+        *previous = value;
 }
 
 gkick_real
@@ -271,24 +727,29 @@ gkick_osc_get_envelope_points(struct gkick_oscillator *osc,
                                           npoints);
 }
 
-void
+enum geonkick_error
 gkick_osc_set_envelope_points(struct gkick_oscillator *osc,
 			      size_t env_index,
 			      const gkick_real *buff,
 			      size_t npoints)
 {
-        if (buff == NULL)
-                return;
+        if (buff == NULL) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
 
         if (env_index == GEONKICK_FILTER_CUTOFF_ENVELOPE)
-                gkick_envelope_set_points(osc->filter->cutoff_env,
-                                          buff,
-                                          npoints);
+                return gkick_envelope_set_points(osc->filter->cutoff_env,
+                                                 buff,
+                                                 npoints);
         else if (env_index == GEONKICK_AMPLITUDE_ENVELOPE
                  || env_index == GEONKICK_FREQUENCY_ENVELOPE)
-                gkick_envelope_set_points(osc->envelopes[env_index],
-                                          buff,
-                                          npoints);
+                return gkick_envelope_set_points(osc->envelopes[env_index],
+                                                 buff,
+                                                 npoints);
+
+        gkick_log_error("wrong envelope index");
+        return GEONKICK_ERROR;
 }
 
 int
@@ -31,6 +31,24 @@
 #define GKICK_OSC_DEFAULT_AMPLITUDE   1.0f
 #define GKICK_OSC_DEFAULT_FREQUENCY   150.0f
 
+/* Maximum number of oscillators of a synthesizer. */
+#define GKICK_OSC_MAX_NUMBER (GKICK_OSC_GROUPS_NUMBER * GKICK_OSC_GROUP_SIZE)
+
+/* Number of frames the waveforms are evaluated at once. */
+#define GKICK_OSC_BLOCK_SIZE 256
+
+/**
+ * The phase is a 32-bit fixed-point fraction of the period,
+ * i.e. the full period is 2^32 and the phase wraps naturally.
+ */
+#define GKICK_OSC_PHASE_PERIOD 4294967296.0
+
+/* Number of the rows of the Voss-McCartney pink noise generator. */
+#define GKICK_OSC_PINK_ROWS 16
+
+/* Key offset between the independent streams of the noise generator. */
+#define GKICK_OSC_NOISE_STREAM 0x9e3779b9u
+
 enum geonkick_osc_state {
         GEONKICK_OSC_STATE_DISABLED = 0,
         GEONKICK_OSC_STATE_ENABLED  = 1
@@ -39,25 +57,24 @@ enum geonkick_osc_state {
 struct gkick_oscillator {
         enum geonkick_osc_state state;
 	enum geonkick_osc_func_type func;
-        /* Used for Brownian noise */
-        gkick_real brownian;
         /* User as a seed for pseudo random generator. */
-        unsigned int seedp;
         unsigned int seed;
         gkick_real initial_phase;
-	gkick_real phase;
 	gkick_real sample_rate;
 	gkick_real frequency;
 	gkick_real amplitude;
 
         struct gkick_buffer *sample;
 
-        /* FM input value for this OSC. */
-        gkick_real fm_input;
-
         /* Specifies if this OSC is a FM source to other oscillator. */
         bool is_fm;
 
+        /**
+         * Specifies if the square, triangle and sawtooth
+         * waveforms are band-limited (PolyBLEP).
+         */
+        bool band_limited;
+
 	size_t env_number;
 	struct gkick_envelope **envelopes;
         struct gkick_filter *filter;
@@ -65,11 +82,45 @@ struct gkick_oscillator {
 	pthread_mutex_t lock;
 };
 
+/**
+ * Synthesis state of the oscillators of a synthesizer.
+ * The frequently accessed fields are kept as arrays
+ * indexed by the oscillator index.
+ */
+struct gkick_osc_state {
+        uint32_t phase[GKICK_OSC_MAX_NUMBER];
+        gkick_real frequency[GKICK_OSC_MAX_NUMBER];
+        gkick_real amplitude[GKICK_OSC_MAX_NUMBER];
+        /* Key of the counter-based noise generator derived from the seed. */
+        uint32_t noise_key[GKICK_OSC_MAX_NUMBER];
+        /* Used for Brownian noise */
+        gkick_real brownian[GKICK_OSC_MAX_NUMBER];
+        /* Rows and their sum of the pink noise generator. */
+        int32_t pink_rows[GKICK_OSC_MAX_NUMBER][GKICK_OSC_PINK_ROWS];
+        int32_t pink_sum[GKICK_OSC_MAX_NUMBER];
+        /* Positions on the amplitude, frequency and filter cutoff envelopes. */
+        struct gkick_envelope_cursor amplitude_cursor[GKICK_OSC_MAX_NUMBER];
+        struct gkick_envelope_cursor frequency_cursor[GKICK_OSC_MAX_NUMBER];
+        struct gkick_envelope_cursor cutoff_cursor[GKICK_OSC_MAX_NUMBER];
+};
+
 struct gkick_oscillator
 *gkick_osc_create(void);
 
 void gkick_osc_free(struct gkick_oscillator **osc);
 
+enum geonkick_error
+gkick_osc_copy(struct gkick_oscillator *dst,
+               struct gkick_oscillator *src);
+
+void
+gkick_osc_set_sample_rate(struct gkick_oscillator *osc,
+                          gkick_real rate);
+
+enum geonkick_error
+gkick_osc_resample_sample(struct gkick_oscillator *osc,
+                          gkick_real rate);
+
 void gkick_osc_set_state(struct gkick_oscillator *osc,
                          enum geonkick_osc_state state);
 
@@ -83,35 +134,115 @@ gkick_osc_get_envelope(struct gkick_oscillator *osc,
                        size_t env_index);
 
 void
-gkick_osc_increment_phase(struct gkick_oscillator *osc,
-			  gkick_real t,
-			  gkick_real kick_len);
-gkick_real
-gkick_osc_value(struct gkick_oscillator *osc,
-		gkick_real t,
-		gkick_real kick_len);
+gkick_osc_reset(struct gkick_oscillator *osc,
+                struct gkick_osc_state *state,
+                size_t index);
 
-gkick_real
-gkick_osc_func_sine(gkick_real phase);
+void
+gkick_osc_render(struct gkick_oscillator *osc,
+                 struct gkick_osc_state *state,
+                 size_t index,
+                 const gkick_real *fm,
+                 gkick_real *out,
+                 size_t offset,
+                 size_t size,
+                 gkick_real dt,
+                 gkick_real kick_len);
 
-gkick_real
-gkick_osc_func_square(gkick_real phase);
+void
+gkick_osc_func_sine(const uint32_t *phase,
+                    const gkick_real *amp,
+                    gkick_real *out,
+                    size_t size);
 
-gkick_real
-gkick_osc_func_triangle(gkick_real phase);
+void
+gkick_osc_func_square(const uint32_t *phase,
+                      const gkick_real *amp,
+                      gkick_real *out,
+                      size_t size);
 
-gkick_real
-gkick_osc_func_sawtooth(gkick_real phase);
+void
+gkick_osc_func_triangle(const uint32_t *phase,
+                        const gkick_real *amp,
+                        gkick_real *out,
+                        size_t size);
+
+void
+gkick_osc_func_sawtooth(const uint32_t *phase,
+                        const gkick_real *amp,
+                        gkick_real *out,
+                        size_t size);
 
 gkick_real
-gkick_osc_func_noise_white(unsigned int *seed);
+gkick_osc_poly_blep(gkick_real t, gkick_real dt);
 
 gkick_real
-gkick_osc_func_noise_pink(void);
+gkick_osc_poly_blamp(gkick_real t, gkick_real dt);
 
 gkick_real
-gkick_osc_func_noise_brownian(gkick_real *previous,
-                              unsigned int *seed);
+gkick_osc_phase_step(uint32_t increment);
+
+void
+gkick_osc_func_square_bl(const uint32_t *phase,
+                         const uint32_t *increment,
+                         const gkick_real *amp,
+                         gkick_real *out,
+                         size_t size);
+
+void
+gkick_osc_func_triangle_bl(const uint32_t *phase,
+                           const uint32_t *increment,
+                           const gkick_real *amp,
+                           gkick_real *out,
+                           size_t size);
+
+void
+gkick_osc_func_sawtooth_bl(const uint32_t *phase,
+                           const uint32_t *increment,
+                           const gkick_real *amp,
+                           gkick_real *out,
+                           size_t size);
+
+uint32_t
+gkick_osc_noise_hash(uint32_t x);
+
+uint32_t
+gkick_osc_noise_value(uint32_t key, uint32_t counter);
+
+void
+gkick_osc_noise_fill(uint32_t key,
+                     uint32_t counter,
+                     uint32_t *out,
+                     size_t size);
+
+void
+gkick_osc_func_noise_white(uint32_t key,
+                           uint32_t counter,
+                           const gkick_real *amp,
+                           gkick_real *out,
+                           size_t size);
+
+void
+gkick_osc_pink_reset(uint32_t key,
+                     int32_t *rows,
+                     int32_t *sum);
+
+void
+gkick_osc_func_noise_pink(uint32_t key,
+                          uint32_t counter,
+                          int32_t *rows,
+                          int32_t *sum,
+                          const gkick_real *amp,
+                          gkick_real *out,
+                          size_t size);
+
+void
+gkick_osc_func_noise_brownian(uint32_t key,
+                              uint32_t counter,
+                              gkick_real *previous,
+                              const gkick_real *amp,
+                              gkick_real *out,
+                              size_t size);
 
 gkick_real
 gkick_osc_func_sample(struct gkick_buffer *sample);
@@ -121,9 +252,10 @@ void gkick_osc_get_envelope_points(struct gkick_oscillator *osc,
                                    gkick_real **buff,
                                    size_t *npoints);
 
-void gkick_osc_set_envelope_points(struct gkick_oscillator *osc,
-                                   size_t env_index,
-                                   const gkick_real *buff,
-                                   size_t npoints);
+enum geonkick_error
+gkick_osc_set_envelope_points(struct gkick_oscillator *osc,
+                              size_t env_index,
+                              const gkick_real *buff,
+                              size_t npoints);
 
 #endif // GKICK_OSCILLATOR_H
@@ -0,0 +1,130 @@
+/**
+ * File name: oversampler.c
+ * Project: Geonkick (A kick synthesizer)
+ *
+ * Copyright (C) 2019 Iurie Nistor <http://geontime.com>
+ *
+ * This file is part of Geonkick.
+ *
+ * GeonKick is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "oversampler.h"
+
+/**
+ * Designs the half-band low pass filter (cutoff at the quarter of the
+ * oversampled rate) as a Blackman windowed sinc. Every second tap of
+ * a half-band filter is zero except the center one, which is 0.5,
+ * so only the taps of the other polyphase branch are stored.
+ */
+void
+gkick_oversampler_init(struct gkick_oversampler *oversampler)
+{
+        size_t taps = 4 * GKICK_HALFBAND_ORDER - 1;
+        gkick_real center = (gkick_real)(taps - 1) / 2;
+        gkick_real sum = 0.0f;
+        for (size_t i = 0; i < GKICK_HALFBAND_TAPS; i++) {
+                gkick_real n = 2 * i;
+                gkick_real x = M_PI * (n - center) / 2;
+                gkick_real window = 0.42 - 0.5 * cos(2 * M_PI * (n + 1) / (taps + 1))
+                        + 0.08 * cos(4 * M_PI * (n + 1) / (taps + 1));
+                oversampler->coefficients[i] = 0.5 * sin(x) / x * window;
+                sum += oversampler->coefficients[i];
+        }
+
+        /* Normalize to the unity gain at DC. */
+        for (size_t i = 0; i < GKICK_HALFBAND_TAPS; i++)
+                oversampler->coefficients[i] *= 0.5f / sum;
+        gkick_oversampler_reset(oversampler);
+}
+
+void
+gkick_oversampler_reset(struct gkick_oversampler *oversampler)
+{
+        memset(oversampler->stages, 0, sizeof(oversampler->stages));
+}
+
+/**
+ * Upsamples by 2 the size input frames into 2 * size output frames.
+ *
+ * The even output frames are the polyphase branch applied on the input,
+ * the odd output frames are the input delayed by the center of the filter.
+ */
+void
+gkick_halfband_upsample(const gkick_real *coefficients,
+                        struct gkick_halfband *halfband,
+                        const gkick_real *in,
+                        gkick_real *out,
+                        size_t size)
+{
+        gkick_real x[GKICK_HALFBAND_TAPS - 1 + GKICK_HALFBAND_BLOCK_SIZE];
+        size_t history = GKICK_HALFBAND_TAPS - 1;
+        for (size_t start = 0; start < size; start += GKICK_HALFBAND_BLOCK_SIZE) {
+                size_t n = size - start;
+                if (n > GKICK_HALFBAND_BLOCK_SIZE)
+                        n = GKICK_HALFBAND_BLOCK_SIZE;
+
+                memcpy(x, halfband->up_history, history * sizeof(gkick_real));
+                memcpy(x + history, in + start, n * sizeof(gkick_real));
+                for (size_t i = 0; i < n; i++) {
+                        gkick_real val = 0.0f;
+                        for (size_t k = 0; k < GKICK_HALFBAND_TAPS; k++)
+                                val += coefficients[k] * x[history + i - k];
+                        out[2 * (start + i)]     = 2.0f * val;
+                        out[2 * (start + i) + 1] = x[GKICK_HALFBAND_ORDER + i];
+                }
+                memcpy(halfband->up_history, x + n, history * sizeof(gkick_real));
+        }
+}
+
+/**
+ * Downsamples by 2 the 2 * size input frames into size output frames.
+ *
+ * The polyphase branch is applied on the even input frames,
+ * the odd input frames are only delayed and weighted by the center tap.
+ */
+void
+gkick_halfband_downsample(const gkick_real *coefficients,
+                          struct gkick_halfband *halfband,
+                          const gkick_real *in,
+                          gkick_real *out,
+                          size_t size)
+{
+        gkick_real even[GKICK_HALFBAND_TAPS - 1 + GKICK_HALFBAND_BLOCK_SIZE];
+        gkick_real odd[GKICK_HALFBAND_ORDER + GKICK_HALFBAND_BLOCK_SIZE];
+        size_t even_history = GKICK_HALFBAND_TAPS - 1;
+        size_t odd_history = GKICK_HALFBAND_ORDER;
+        for (size_t start = 0; start < size; start += GKICK_HALFBAND_BLOCK_SIZE) {
+                size_t n = size - start;
+                if (n > GKICK_HALFBAND_BLOCK_SIZE)
+                        n = GKICK_HALFBAND_BLOCK_SIZE;
+
+                memcpy(even, halfband->down_even, even_history * sizeof(gkick_real));
+                memcpy(odd, halfband->down_odd, odd_history * sizeof(gkick_real));
+                for (size_t i = 0; i < n; i++) {
+                        even[even_history + i] = in[2 * (start + i)];
+                        odd[odd_history + i]   = in[2 * (start + i) + 1];
+                }
+
+                for (size_t i = 0; i < n; i++) {
+                        gkick_real val = 0.0f;
+                        for (size_t k = 0; k < GKICK_HALFBAND_TAPS; k++)
+                                val += coefficients[k] * even[even_history + i - k];
+                        out[start + i] = val + 0.5f * odd[i];
+                }
+                memcpy(halfband->down_even, even + n, even_history * sizeof(gkick_real));
+                memcpy(halfband->down_odd, odd + n, odd_history * sizeof(gkick_real));
+        }
+}
@@ -0,0 +1,81 @@
+/**
+ * File name: oversampler.h
+ * Project: Geonkick (A kick synthesizer)
+ *
+ * Copyright (C) 2019 Iurie Nistor <http://geontime.com>
+ *
+ * This file is part of Geonkick.
+ *
+ * GeonKick is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef GEONKICK_OVERSAMPLER_H
+#define GEONKICK_OVERSAMPLER_H
+
+#include "geonkick.h"
+
+/**
+ * Order of the half-band filter. The filter has 4 * order - 1 taps,
+ * 2 * order of them (the polyphase branch) are not trivial.
+ */
+#define GKICK_HALFBAND_ORDER 8
+#define GKICK_HALFBAND_TAPS (2 * GKICK_HALFBAND_ORDER)
+
+/* Maximum number of input frames processed at once by a half-band stage. */
+#define GKICK_HALFBAND_BLOCK_SIZE 256
+
+/* Maximum oversampling factor, 2 for every half-band stage. */
+#define GKICK_OVERSAMPLER_MAX_FACTOR 4
+
+/* State of a 2x half-band stage. */
+struct gkick_halfband {
+        /* Last input frames of the upsampler. */
+        gkick_real up_history[GKICK_HALFBAND_TAPS - 1];
+        /* Last even and odd frames of the downsampler input. */
+        gkick_real down_even[GKICK_HALFBAND_TAPS - 1];
+        gkick_real down_odd[GKICK_HALFBAND_ORDER];
+};
+
+/**
+ * Oversampler by 2 or 4 with polyphase half-band FIR filters,
+ * one 2x stage for every factor of 2.
+ */
+struct gkick_oversampler {
+        /* Coefficients of the polyphase branch of the half-band filter. */
+        gkick_real coefficients[GKICK_HALFBAND_TAPS];
+        struct gkick_halfband stages[2];
+};
+
+void
+gkick_oversampler_init(struct gkick_oversampler *oversampler);
+
+void
+gkick_oversampler_reset(struct gkick_oversampler *oversampler);
+
+void
+gkick_halfband_upsample(const gkick_real *coefficients,
+                        struct gkick_halfband *halfband,
+                        const gkick_real *in,
+                        gkick_real *out,
+                        size_t size);
+
+void
+gkick_halfband_downsample(const gkick_real *coefficients,
+                          struct gkick_halfband *halfband,
+                          const gkick_real *in,
+                          gkick_real *out,
+                          size_t size);
+
+#endif // GEONKICK_OVERSAMPLER_H
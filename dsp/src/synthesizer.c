@@ -42,7 +42,8 @@ gkick_synth_new(struct gkick_synth **synth)
 	(*synth)->oscillators_number = GKICK_OSC_GROUPS_NUMBER * GKICK_OSC_GROUP_SIZE;
         (*synth)->buffer_update = 0;
         (*synth)->amplitude = 1.0f;
-        (*synth)->buffer_size = (size_t)((*synth)->length * GEONKICK_SAMPLE_RATE);
+        (*synth)->sample_rate = GEONKICK_DEFAULT_SAMPLE_RATE;
+        (*synth)->buffer_size = (size_t)((*synth)->length * (*synth)->sample_rate);
         (*synth)->buffer_update = false;
         (*synth)->is_active = false;
         memset((*synth)->name, '\0', sizeof((*synth)->name));
@@ -101,6 +102,19 @@ gkick_synth_new(struct gkick_synth **synth)
                 return GEONKICK_ERROR;
         }
 
+        if (gkick_synth_snapshot_new(&(*synth)->snapshot,
+                                     (*synth)->oscillators_number) != GEONKICK_OK) {
+                gkick_log_error("can't create synthesizer snapshot");
+                gkick_synth_free(synth);
+                return GEONKICK_ERROR;
+        }
+
+        if (gkick_synth_render_new(&(*synth)->render) != GEONKICK_OK) {
+                gkick_log_error("can't create synthesizer render");
+                gkick_synth_free(synth);
+                return GEONKICK_ERROR;
+        }
+
         return GEONKICK_OK;
 }
 
@@ -135,6 +149,9 @@ void gkick_synth_free(struct gkick_synth **synth)
                         }
                 }
 
+                gkick_synth_snapshot_free(&(*synth)->snapshot);
+                gkick_synth_render_free(&(*synth)->render);
+
                 pthread_mutex_destroy(&(*synth)->lock);
                 free(*synth);
                 *synth = NULL;
@@ -180,6 +197,453 @@ gkick_synth_create_oscillators(struct gkick_synth *synth)
         return GEONKICK_OK;
 }
 
+enum geonkick_error
+gkick_synth_snapshot_new(struct gkick_synth_snapshot **snapshot,
+                         size_t oscillators_number)
+{
+        if (snapshot == NULL) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+
+        *snapshot = (struct gkick_synth_snapshot*)calloc(1, sizeof(struct gkick_synth_snapshot));
+        if (*snapshot == NULL) {
+                gkick_log_error("can't allocate memory");
+                return GEONKICK_ERROR_MEM_ALLOC;
+        }
+
+        (*snapshot)->oscillators = (struct gkick_oscillator**)calloc(oscillators_number,
+                                                                     sizeof(struct gkick_oscillator*));
+        if ((*snapshot)->oscillators == NULL) {
+                gkick_log_error("can't allocate memory");
+                gkick_synth_snapshot_free(snapshot);
+                return GEONKICK_ERROR_MEM_ALLOC;
+        }
+        (*snapshot)->oscillators_number = oscillators_number;
+
+        for (size_t i = 0; i < oscillators_number; i++) {
+                (*snapshot)->oscillators[i] = gkick_osc_create();
+                if ((*snapshot)->oscillators[i] == NULL) {
+                        gkick_log_error("can't create oscillator");
+                        gkick_synth_snapshot_free(snapshot);
+                        return GEONKICK_ERROR;
+                }
+        }
+
+        if (gkick_filter_new(&(*snapshot)->filter) != GEONKICK_OK
+            || gkick_compressor_new(&(*snapshot)->compressor) != GEONKICK_OK
+            || gkick_distortion_new(&(*snapshot)->distortion) != GEONKICK_OK) {
+                gkick_log_error("can't create snapshot effects");
+                gkick_synth_snapshot_free(snapshot);
+                return GEONKICK_ERROR;
+        }
+
+        (*snapshot)->envelope = gkick_envelope_create();
+        if ((*snapshot)->envelope == NULL) {
+                gkick_log_error("can't create envelope");
+                gkick_synth_snapshot_free(snapshot);
+                return GEONKICK_ERROR;
+        }
+
+        return GEONKICK_OK;
+}
+
+void
+gkick_synth_snapshot_free(struct gkick_synth_snapshot **snapshot)
+{
+        if (snapshot == NULL || *snapshot == NULL)
+                return;
+
+        if ((*snapshot)->oscillators != NULL) {
+                for (size_t i = 0; i < (*snapshot)->oscillators_number; i++)
+                        gkick_osc_free(&(*snapshot)->oscillators[i]);
+                free((*snapshot)->oscillators);
+        }
+
+        if ((*snapshot)->filter)
+                gkick_filter_free(&(*snapshot)->filter);
+
+        if ((*snapshot)->compressor)
+                gkick_compressor_free(&(*snapshot)->compressor);
+
+        if ((*snapshot)->distortion)
+                gkick_distortion_free(&(*snapshot)->distortion);
+
+        if ((*snapshot)->envelope)
+                gkick_envelope_destroy((*snapshot)->envelope);
+
+        free(*snapshot);
+        *snapshot = NULL;
+}
+
+/**
+ * Copies the current version of the synthesizer parameters
+ * into the synthesizer snapshot. Must be called with the
+ * synthesizer locked and only by the worker.
+ */
+enum geonkick_error
+gkick_synth_take_snapshot(struct gkick_synth *synth)
+{
+        if (synth == NULL) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+
+        struct gkick_synth_snapshot *snapshot = synth->snapshot;
+        struct gkick_synth_render *render = synth->render;
+        /**
+         * The version must be taken before the dirty flags, so a change
+         * that sets its dirty flag after they were taken always
+         * invalidates this snapshot.
+         */
+        snapshot->version = synth->version;
+        render->osc_dirty |= atomic_exchange(&synth->osc_dirty, 0);
+        render->stages_dirty |= atomic_exchange(&synth->stages_dirty, 0);
+
+        snapshot->buffer_size = synth->buffer_size;
+        snapshot->sample_rate = synth->sample_rate;
+        snapshot->length      = synth->length;
+        snapshot->amplitude   = synth->amplitude;
+        memcpy(snapshot->osc_groups, synth->osc_groups,
+               sizeof(snapshot->osc_groups));
+        memcpy(snapshot->osc_groups_amplitude, synth->osc_groups_amplitude,
+               sizeof(snapshot->osc_groups_amplitude));
+        for (size_t i = 0; i < synth->oscillators_number; i++) {
+                if (!(render->osc_dirty & (1u << i)))
+                        continue;
+                if (gkick_osc_copy(snapshot->oscillators[i],
+                                   synth->oscillators[i]) != GEONKICK_OK) {
+                        gkick_log_error("can't copy oscillator");
+                        return GEONKICK_ERROR;
+                }
+        }
+        gkick_filter_copy(snapshot->filter, synth->filter);
+        snapshot->filter_enabled = synth->filter_enabled;
+        gkick_compressor_copy(snapshot->compressor, synth->compressor);
+        gkick_distortion_copy(snapshot->distortion, synth->distortion);
+        gkick_envelope_copy(snapshot->envelope, synth->envelope);
+        synth->buffer_update = false;
+
+        return GEONKICK_OK;
+}
+
+/**
+ * Starts a new version of the synthesizer parameters
+ * and requests the synthesis of the percussion.
+ */
+void
+gkick_synth_params_changed(struct gkick_synth *synth)
+{
+        synth->version++;
+        synth->buffer_update = true;
+}
+
+/**
+ * Marks the oscillator as changed. Only the changed oscillators
+ * are synthesized again, the other are taken from the cache.
+ */
+void
+gkick_synth_osc_changed(struct gkick_synth *synth, size_t index)
+{
+        synth->osc_dirty |= 1u << index;
+        gkick_synth_params_changed(synth);
+}
+
+/* Marks a stage of the synthesis as changed. */
+void
+gkick_synth_stage_changed(struct gkick_synth *synth,
+                          enum gkick_synth_stage stage)
+{
+        synth->stages_dirty |= stage;
+        gkick_synth_params_changed(synth);
+}
+
+/**
+ * Marks as changed the stage that uses the kick envelope.
+ * Must be called with the synthesizer locked.
+ */
+void
+gkick_synth_kick_env_changed(struct gkick_synth *synth,
+                             enum geonkick_envelope_type env_type)
+{
+        if (env_type == GEONKICK_AMPLITUDE_ENVELOPE)
+                gkick_synth_stage_changed(synth, GKICK_SYNTH_STAGE_MIX);
+        else if (env_type == GEONKICK_FILTER_CUTOFF_ENVELOPE && synth->filter_enabled)
+                gkick_synth_stage_changed(synth, GKICK_SYNTH_STAGE_FILTER);
+        else if (env_type == GEONKICK_DISTORTION_DRIVE_ENVELOPE && atomic_load(&synth->distortion->enabled))
+                gkick_synth_params_changed(synth);
+}
+
+enum geonkick_error
+gkick_synth_render_new(struct gkick_synth_render **render)
+{
+        if (render == NULL) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+
+        *render = (struct gkick_synth_render*)calloc(1, sizeof(struct gkick_synth_render));
+        if (*render == NULL) {
+                gkick_log_error("can't allocate memory");
+                return GEONKICK_ERROR_MEM_ALLOC;
+        }
+
+        (*render)->osc_state = (struct gkick_osc_state*)calloc(1, sizeof(struct gkick_osc_state));
+        if ((*render)->osc_state == NULL) {
+                gkick_log_error("can't allocate memory");
+                gkick_synth_render_free(render);
+                return GEONKICK_ERROR_MEM_ALLOC;
+        }
+
+        /* Nothing is cached before the first synthesis. */
+        (*render)->osc_dirty = GKICK_SYNTH_OSC_ALL;
+        (*render)->stages_dirty = GKICK_SYNTH_STAGE_ALL;
+
+        return GEONKICK_OK;
+}
+
+void
+gkick_synth_render_free(struct gkick_synth_render **render)
+{
+        if (render == NULL || *render == NULL)
+                return;
+
+        for (size_t i = 0; i < GKICK_OSC_MAX_NUMBER; i++)
+                free((*render)->osc_buffers[i]);
+        free((*render)->mix_buffer);
+        free((*render)->filter_buffer);
+        free((*render)->osc_state);
+        free(*render);
+        *render = NULL;
+}
+
+/**
+ * Allocates the synthesis buffers and resets the
+ * synthesis state of the oscillators to be synthesized.
+ *
+ * Also resolves the dependencies between the cached stages:
+ * a changed FM source changes the modulated oscillator,
+ * any changed oscillator changes the mix, and a changed mix
+ * changes the kick filter output.
+ */
+enum geonkick_error
+gkick_synth_render_prepare(struct gkick_synth_render *render,
+                           struct gkick_synth_snapshot *snapshot)
+{
+        if (render == NULL || snapshot == NULL) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+
+        size_t size = snapshot->buffer_size;
+        if (render->mix_buffer_size < size) {
+                free(render->mix_buffer);
+                render->mix_buffer = gkick_synth_render_alloc(size);
+                if (render->mix_buffer == NULL) {
+                        render->mix_buffer_size = 0;
+                        return GEONKICK_ERROR_MEM_ALLOC;
+                }
+                render->mix_buffer_size = size;
+                render->stages_dirty |= GKICK_SYNTH_STAGE_ALL;
+        }
+
+        if (snapshot->filter_enabled && render->filter_buffer_size < size) {
+                free(render->filter_buffer);
+                render->filter_buffer = gkick_synth_render_alloc(size);
+                if (render->filter_buffer == NULL) {
+                        render->filter_buffer_size = 0;
+                        return GEONKICK_ERROR_MEM_ALLOC;
+                }
+                render->filter_buffer_size = size;
+                render->stages_dirty |= GKICK_SYNTH_STAGE_FILTER;
+        }
+
+        for (size_t i = 0; i < snapshot->oscillators_number; i++) {
+                if ((render->osc_dirty & (1u << i))
+                    && i % GKICK_OSC_GROUP_SIZE == 0
+                    && i + 1 < snapshot->oscillators_number)
+                        render->osc_dirty |= 1u << (i + 1);
+        }
+
+        if (render->osc_dirty)
+                render->stages_dirty |= GKICK_SYNTH_STAGE_MIX;
+        if (render->stages_dirty & GKICK_SYNTH_STAGE_MIX) {
+                render->stages_dirty |= GKICK_SYNTH_STAGE_FILTER;
+                gkick_envelope_cursor_reset(&render->envelope_cursor);
+        }
+        if (render->stages_dirty & GKICK_SYNTH_STAGE_FILTER) {
+                gkick_filter_init(snapshot->filter);
+                gkick_envelope_cursor_reset(&render->cutoff_cursor);
+        }
+        gkick_envelope_cursor_reset(&render->drive_cursor);
+
+        for (size_t i = 0; i < snapshot->oscillators_number; i++) {
+                if (!(render->osc_dirty & (1u << i)))
+                        continue;
+
+                gkick_osc_reset(snapshot->oscillators[i], render->osc_state, i);
+                if (!gkick_synth_osc_is_rendered(snapshot, i)
+                    || render->osc_buffers_size[i] >= size)
+                        continue;
+
+                free(render->osc_buffers[i]);
+                render->osc_buffers[i] = gkick_synth_render_alloc(size);
+                if (render->osc_buffers[i] == NULL) {
+                        render->osc_buffers_size[i] = 0;
+                        return GEONKICK_ERROR_MEM_ALLOC;
+                }
+                render->osc_buffers_size[i] = size;
+        }
+
+        return GEONKICK_OK;
+}
+
+/* Allocates an aligned synthesis buffer of the given size in frames. */
+gkick_real*
+gkick_synth_render_alloc(size_t size)
+{
+        void *buff = NULL;
+        if (posix_memalign(&buff, GKICK_SYNTH_BUFFER_ALIGNMENT,
+                           size * sizeof(gkick_real)) != 0) {
+                gkick_log_error("can't allocate memory");
+                return NULL;
+        }
+        return (gkick_real*)buff;
+}
+
+/**
+ * Marks all the stages as synthesized. Called
+ * after the synthesis of the whole percussion.
+ */
+void
+gkick_synth_render_done(struct gkick_synth_render *render)
+{
+        render->osc_dirty = 0;
+        render->stages_dirty = 0;
+}
+
+/* Checks if the oscillator takes part in the synthesis. */
+bool
+gkick_synth_osc_is_rendered(struct gkick_synth_snapshot *snapshot,
+                            size_t index)
+{
+        return snapshot->osc_groups[index / GKICK_OSC_GROUP_SIZE]
+                && gkick_osc_enabled(snapshot->oscillators[index]);
+}
+
+/**
+ * Checks if the oscillator is used only as FM source
+ * for the next oscillator in the group.
+ */
+bool
+gkick_synth_osc_is_fm_source(struct gkick_synth_snapshot *snapshot,
+                             size_t index)
+{
+        return snapshot->oscillators[index]->is_fm
+                && index % GKICK_OSC_GROUP_SIZE == 0
+                && index + 1 < snapshot->oscillators_number;
+}
+
+/**
+ * Renders a block of the percussion into the out buffer.
+ *
+ * Every changed oscillator is rendered into its own buffer,
+ * then the oscillators are mixed, the kick amplitude envelope
+ * and the kick filter are applied, each stage only if changed.
+ * The kick effects are always applied on the cached output
+ * of the last stage.
+ *
+ * The size of the block must not exceed GKICK_SYNTH_BLOCK_SIZE.
+ */
+void
+gkick_synth_render_block(struct gkick_synth_render *render,
+                         struct gkick_synth_snapshot *snapshot,
+                         size_t offset,
+                         size_t size,
+                         gkick_real dt,
+                         gkick_real *out)
+{
+        size_t n = snapshot->oscillators_number;
+        for (size_t i = 0; i < n; i++) {
+                if (!(render->osc_dirty & (1u << i))
+                    || !gkick_synth_osc_is_rendered(snapshot, i))
+                        continue;
+
+                const gkick_real *fm = NULL;
+                if (i % GKICK_OSC_GROUP_SIZE != 0
+                    && gkick_synth_osc_is_rendered(snapshot, i - 1)
+                    && gkick_synth_osc_is_fm_source(snapshot, i - 1))
+                        fm = render->osc_buffers[i - 1] + offset;
+                gkick_osc_render(snapshot->oscillators[i],
+                                 render->osc_state,
+                                 i,
+                                 fm,
+                                 render->osc_buffers[i] + offset,
+                                 offset,
+                                 size,
+                                 dt,
+                                 snapshot->length);
+        }
+
+        /* Step of the envelopes x coordinate per frame. */
+        gkick_real env_dx = dt / snapshot->length;
+        _Alignas(GKICK_SYNTH_BUFFER_ALIGNMENT) gkick_real curve[GKICK_SYNTH_BLOCK_SIZE];
+        gkick_real *mix = render->mix_buffer + offset;
+        if (render->stages_dirty & GKICK_SYNTH_STAGE_MIX) {
+                /* Mix the oscillators. */
+                memset(mix, 0, size * sizeof(gkick_real));
+                for (size_t i = 0; i < n; i++) {
+                        if (!gkick_synth_osc_is_rendered(snapshot, i)
+                            || gkick_synth_osc_is_fm_source(snapshot, i))
+                                continue;
+
+                        gkick_real group_ampl = snapshot->osc_groups_amplitude[i / GKICK_OSC_GROUP_SIZE];
+                        const gkick_real *in = render->osc_buffers[i] + offset;
+                        for (size_t j = 0; j < size; j++)
+                                mix[j] += group_ampl * in[j];
+                }
+
+                /* Apply the kick amplitude and amplitude envelope. */
+                gkick_envelope_render(snapshot->envelope,
+                                      &render->envelope_cursor,
+                                      offset,
+                                      env_dx,
+                                      curve,
+                                      size);
+                for (size_t j = 0; j < size; j++)
+                        mix[j] *= snapshot->amplitude * curve[j];
+        }
+
+        const gkick_real *in = mix;
+        if (snapshot->filter_enabled) {
+                gkick_real *filtered = render->filter_buffer + offset;
+                if (render->stages_dirty & GKICK_SYNTH_STAGE_FILTER) {
+                        gkick_envelope_render(snapshot->filter->cutoff_env,
+                                              &render->cutoff_cursor,
+                                              offset,
+                                              env_dx,
+                                              curve,
+                                              size);
+                        gkick_filter_process(snapshot->filter, mix, filtered, size, curve);
+                }
+                in = filtered;
+        }
+
+        /* Apply the kick effects. */
+        memcpy(out, in, size * sizeof(gkick_real));
+        if (atomic_load(&snapshot->distortion->enabled)) {
+                gkick_envelope_render(snapshot->distortion->drive_env,
+                                      &render->drive_cursor,
+                                      offset,
+                                      env_dx,
+                                      curve,
+                                      size);
+                gkick_distortion_process(snapshot->distortion, out, out, size, curve);
+        }
+        if (atomic_load(&snapshot->compressor->enabled))
+                gkick_compressor_process(snapshot->compressor, out, out, size);
+}
+
 struct gkick_oscillator*
 gkick_synth_get_oscillator(struct gkick_synth *synth,
                            size_t index)
@@ -235,7 +699,7 @@ gkick_synth_enable_oscillator(struct gkick_synth *synth,
                 gkick_osc_set_state(osc, GEONKICK_OSC_STATE_DISABLED);
 
         if (synth->osc_groups[index / GKICK_OSC_GROUP_SIZE])
-                synth->buffer_update = true;
+                gkick_synth_osc_changed(synth, index);
 
 	gkick_synth_unlock(synth);
 
@@ -282,7 +746,7 @@ gkick_synth_osc_set_fm(struct gkick_synth *synth,
 
         osc->is_fm = is_fm;
         if (osc->state == GEONKICK_OSC_STATE_ENABLED)
-                synth->buffer_update = true;
+                gkick_synth_osc_changed(synth, index);
 
 	gkick_synth_unlock(synth);
 
@@ -308,6 +772,50 @@ gkick_synth_osc_is_fm(struct gkick_synth *synth,
         return GEONKICK_OK;
 }
 
+enum geonkick_error
+gkick_synth_osc_set_band_limited(struct gkick_synth *synth,
+                                 size_t index,
+                                 bool band_limited)
+{
+        gkick_synth_lock(synth);
+	struct gkick_oscillator* osc = gkick_synth_get_oscillator(synth, index);
+	if (osc == NULL) {
+		gkick_log_error("can't get oscillator");
+		gkick_synth_unlock(synth);
+		return GEONKICK_ERROR;
+	}
+
+        osc->band_limited = band_limited;
+        if (osc->state == GEONKICK_OSC_STATE_ENABLED
+            && (osc->func == GEONKICK_OSC_FUNC_SQUARE
+                || osc->func == GEONKICK_OSC_FUNC_TRIANGLE
+                || osc->func == GEONKICK_OSC_FUNC_SAWTOOTH))
+                gkick_synth_osc_changed(synth, index);
+
+	gkick_synth_unlock(synth);
+
+        return GEONKICK_OK;
+}
+
+enum geonkick_error
+gkick_synth_osc_is_band_limited(struct gkick_synth *synth,
+                                size_t index,
+                                bool *band_limited)
+{
+        gkick_synth_lock(synth);
+	struct gkick_oscillator* osc = gkick_synth_get_oscillator(synth, index);
+	if (osc == NULL) {
+		gkick_log_error("can't get oscillator");
+		gkick_synth_unlock(synth);
+		return GEONKICK_ERROR;
+	}
+
+        *band_limited = osc->band_limited;
+	gkick_synth_unlock(synth);
+
+        return GEONKICK_OK;
+}
+
 struct gkick_envelope*
 gkick_synth_osc_get_env(struct gkick_synth *synth,
                         size_t osc_index,
@@ -364,7 +872,8 @@ gkick_synth_osc_envelope_set_points(struct gkick_synth *synth,
                                     const gkick_real *buf,
                                     size_t npoints)
 {
-        if (synth == NULL || buf == NULL || npoints == 0) {
+        if (synth == NULL || buf == NULL || npoints == 0
+            || npoints > GKICK_ENVELOPE_MAX_POINTS) {
                 gkick_log_error("wrong arguments");
                 return GEONKICK_ERROR;
         }
@@ -376,14 +885,15 @@ gkick_synth_osc_envelope_set_points(struct gkick_synth *synth,
                 gkick_synth_unlock(synth);
                 return GEONKICK_ERROR;
         }
-        gkick_osc_set_envelope_points(osc, env_index, buf, npoints);
-        if (synth->osc_groups[osc_index / GKICK_OSC_GROUP_SIZE]
+        enum geonkick_error res = gkick_osc_set_envelope_points(osc, env_index, buf, npoints);
+        if (res == GEONKICK_OK
+            && synth->osc_groups[osc_index / GKICK_OSC_GROUP_SIZE]
             && osc->state == GEONKICK_OSC_STATE_ENABLED) {
-                synth->buffer_update = true;
+                gkick_synth_osc_changed(synth, osc_index);
         }
         gkick_synth_unlock(synth);
 
-        return GEONKICK_OK;
+        return res;
 }
 
 enum geonkick_error
@@ -420,7 +930,7 @@ gkick_synth_osc_env_add_point(struct gkick_synth *synth,
                 return GEONKICK_ERROR;
         }
 
-        if (gkick_envelope_add_point(env, x, y) == NULL) {
+        if (gkick_envelope_add_point(env, x, y) != GEONKICK_OK) {
                 gkick_log_error("can't add envelope point");
                 gkick_synth_unlock(synth);
                 return GEONKICK_ERROR;
@@ -428,7 +938,7 @@ gkick_synth_osc_env_add_point(struct gkick_synth *synth,
 
         if (synth->osc_groups[osc_index / GKICK_OSC_GROUP_SIZE]
             && osc->state == GEONKICK_OSC_STATE_ENABLED) {
-                synth->buffer_update = true;
+                gkick_synth_osc_changed(synth, osc_index);
         }
 
         gkick_synth_unlock(synth);
@@ -467,14 +977,15 @@ gkick_synth_osc_env_remove_point(struct gkick_synth *synth,
                 return GEONKICK_ERROR;
         }
 
-        gkick_envelope_remove_point(env, index);
-        if (synth->osc_groups[osc_index / GKICK_OSC_GROUP_SIZE]
+        enum geonkick_error res = gkick_envelope_remove_point(env, index);
+        if (res == GEONKICK_OK
+            && synth->osc_groups[osc_index / GKICK_OSC_GROUP_SIZE]
             && osc->state == GEONKICK_OSC_STATE_ENABLED) {
-                synth->buffer_update = true;
+                gkick_synth_osc_changed(synth, osc_index);
         }
 
         gkick_synth_unlock(synth);
-        return GEONKICK_OK;
+        return res;
 }
 
 enum geonkick_error
@@ -512,15 +1023,16 @@ gkick_synth_osc_env_update_point(struct gkick_synth *synth,
                 return GEONKICK_ERROR;
         }
 
-        gkick_envelope_update_point(env, index, x, y);
-        if (synth->osc_groups[osc_index / GKICK_OSC_GROUP_SIZE]
+        enum geonkick_error res = gkick_envelope_update_point(env, index, x, y);
+        if (res == GEONKICK_OK
+            && synth->osc_groups[osc_index / GKICK_OSC_GROUP_SIZE]
             && osc->state == GEONKICK_OSC_STATE_ENABLED) {
-                synth->buffer_update = true;
+                gkick_synth_osc_changed(synth, osc_index);
         }
 
         gkick_synth_unlock(synth);
 
-        return GEONKICK_OK;
+        return res;
 }
 
 enum geonkick_error
@@ -546,7 +1058,7 @@ gkick_synth_set_osc_function(struct gkick_synth *synth,
 
         if (synth->osc_groups[osc_index / GKICK_OSC_GROUP_SIZE]
                     && osc->state == GEONKICK_OSC_STATE_ENABLED) {
-                synth->buffer_update = true;
+                gkick_synth_osc_changed(synth, osc_index);
         }
 
         gkick_synth_unlock(synth);
@@ -602,7 +1114,7 @@ gkick_synth_set_osc_phase(struct gkick_synth *synth,
 
         if (synth->osc_groups[osc_index / GKICK_OSC_GROUP_SIZE]
             && osc->state == GEONKICK_OSC_STATE_ENABLED)
-                synth->buffer_update = true;
+                gkick_synth_osc_changed(synth, osc_index);
 
 	gkick_synth_unlock(synth);
         return GEONKICK_OK;
@@ -656,7 +1168,7 @@ gkick_synth_set_osc_seed(struct gkick_synth *synth,
 
         if (synth->osc_groups[osc_index / GKICK_OSC_GROUP_SIZE]
             && osc->state == GEONKICK_OSC_STATE_ENABLED)
-                synth->buffer_update = true;
+                gkick_synth_osc_changed(synth, osc_index);
 
 	gkick_synth_unlock(synth);
         return GEONKICK_OK;
@@ -714,8 +1226,41 @@ gkick_synth_set_length(struct gkick_synth *synth,
 
         gkick_synth_lock(synth);
         synth->length = len;
-        synth->buffer_size = synth->length * GEONKICK_SAMPLE_RATE;
-        synth->buffer_update = true;
+        synth->buffer_size = synth->length * synth->sample_rate;
+        synth->osc_dirty |= GKICK_SYNTH_OSC_ALL;
+        gkick_synth_stage_changed(synth, GKICK_SYNTH_STAGE_ALL);
+        gkick_synth_unlock(synth);
+
+        return GEONKICK_OK;
+}
+
+/**
+ * Sets the sample rate of the synthesis. The buffers are
+ * reallocated for the new sample rate by the worker.
+ */
+enum geonkick_error
+gkick_synth_set_sample_rate(struct gkick_synth *synth,
+                            gkick_real rate)
+{
+        if (synth == NULL || rate < 1.0f) {
+                gkick_log_error("wrong arguments");
+                return GEONKICK_ERROR;
+        }
+
+        gkick_synth_lock(synth);
+        if (synth->sample_rate == rate) {
+                gkick_synth_unlock(synth);
+                return GEONKICK_OK;
+        }
+
+        synth->sample_rate = rate;
+        synth->buffer_size = synth->length * synth->sample_rate;
+        for (size_t i = 0; i < synth->oscillators_number; i++)
+                gkick_osc_set_sample_rate(synth->oscillators[i], rate);
+        gkick_filter_set_sample_rate(synth->filter, rate);
+        gkick_compressor_set_sample_rate(synth->compressor, rate);
+        synth->osc_dirty |= GKICK_SYNTH_OSC_ALL;
+        gkick_synth_stage_changed(synth, GKICK_SYNTH_STAGE_ALL);
         gkick_synth_unlock(synth);
 
         return GEONKICK_OK;
@@ -732,7 +1277,7 @@ gkick_synth_kick_set_amplitude(struct gkick_synth *synth,
 
         gkick_synth_lock(synth);
         synth->amplitude = amplitude;
-        synth->buffer_update = true;
+        gkick_synth_stage_changed(synth, GKICK_SYNTH_STAGE_MIX);
         gkick_synth_unlock(synth);
         return GEONKICK_OK;
 }
@@ -763,7 +1308,7 @@ geonkick_synth_kick_filter_enable(struct gkick_synth *synth,
 
         gkick_synth_lock(synth);
         synth->filter_enabled = enable;
-        synth->buffer_update = true;
+        gkick_synth_stage_changed(synth, GKICK_SYNTH_STAGE_FILTER);
         gkick_synth_unlock(synth);
 
         return GEONKICK_OK;
@@ -797,7 +1342,7 @@ gkick_synth_kick_set_filter_frequency(struct gkick_synth *synth,
         gkick_synth_lock(synth);
         res = gkick_filter_set_cutoff_freq(synth->filter, frequency);
         if (synth->filter_enabled)
-                synth->buffer_update = true;
+                gkick_synth_stage_changed(synth, GKICK_SYNTH_STAGE_FILTER);
         gkick_synth_unlock(synth);
         return res;
 }
@@ -827,7 +1372,7 @@ gkick_synth_kick_set_filter_factor(struct gkick_synth *synth,
         gkick_synth_lock(synth);
         res = gkick_filter_set_factor(synth->filter, factor);
         if (synth->filter_enabled)
-                synth->buffer_update = true;
+                gkick_synth_stage_changed(synth, GKICK_SYNTH_STAGE_FILTER);
         gkick_synth_unlock(synth);
         return res;
 }
@@ -857,7 +1402,7 @@ gkick_synth_set_kick_filter_type(struct gkick_synth *synth,
         gkick_synth_lock(synth);
         res = gkick_filter_set_type(synth->filter, type);
         if (synth->filter_enabled)
-                synth->buffer_update = true;
+                gkick_synth_stage_changed(synth, GKICK_SYNTH_STAGE_FILTER);
         gkick_synth_unlock(synth);
         return res;
 }
@@ -912,34 +1457,30 @@ gkick_synth_kick_envelope_set_points(struct gkick_synth *synth,
                                      const gkick_real *buf,
                                      size_t npoints)
 {
-        if (synth == NULL || buf == NULL) {
+        if (synth == NULL || buf == NULL || npoints > GKICK_ENVELOPE_MAX_POINTS) {
                 gkick_log_error("wrong arguments");
                 return GEONKICK_ERROR;
         }
 
+        enum geonkick_error res = GEONKICK_OK;
         gkick_synth_lock(synth);
         if (env_type == GEONKICK_AMPLITUDE_ENVELOPE)
-                gkick_envelope_set_points(synth->envelope,
-                                          buf,
-                                          npoints);
+                res = gkick_envelope_set_points(synth->envelope,
+                                                buf,
+                                                npoints);
         else if (env_type == GEONKICK_FILTER_CUTOFF_ENVELOPE)
-                gkick_envelope_set_points(synth->filter->cutoff_env,
-                                          buf,
-                                          npoints);
+                res = gkick_envelope_set_points(synth->filter->cutoff_env,
+                                                buf,
+                                                npoints);
 	else if (env_type == GEONKICK_DISTORTION_DRIVE_ENVELOPE)
-		gkick_envelope_set_points(synth->distortion->drive_env,
-                                          buf,
-                                          npoints);
+		res = gkick_envelope_set_points(synth->distortion->drive_env,
+                                                buf,
+                                                npoints);
 
-	if (env_type == GEONKICK_AMPLITUDE_ENVELOPE
-            || (env_type == GEONKICK_FILTER_CUTOFF_ENVELOPE
-                && synth->filter_enabled)
-	    || (env_type == GEONKICK_DISTORTION_DRIVE_ENVELOPE
-                && synth->distortion->enabled)) {
-                synth->buffer_update = true;
-        }
+        if (res == GEONKICK_OK)
+                gkick_synth_kick_env_changed(synth, env_type);
         gkick_synth_unlock(synth);
-        return GEONKICK_OK;
+        return res;
 }
 
 enum geonkick_error
@@ -953,22 +1494,19 @@ gkick_synth_kick_add_env_point(struct gkick_synth *synth,
                 return GEONKICK_ERROR;
         }
 
+        enum geonkick_error res = GEONKICK_OK;
         gkick_synth_lock(synth);
         if (env_type == GEONKICK_AMPLITUDE_ENVELOPE)
-                gkick_envelope_add_point(synth->envelope, x, y);
+                res = gkick_envelope_add_point(synth->envelope, x, y);
         else if (env_type == GEONKICK_FILTER_CUTOFF_ENVELOPE)
-                gkick_envelope_add_point(synth->filter->cutoff_env, x, y);
+                res = gkick_envelope_add_point(synth->filter->cutoff_env, x, y);
 	else if (env_type == GEONKICK_DISTORTION_DRIVE_ENVELOPE)
-		gkick_envelope_add_point(synth->distortion->drive_env, x, y);
-
-        if (env_type == GEONKICK_AMPLITUDE_ENVELOPE
-            || (env_type == GEONKICK_FILTER_CUTOFF_ENVELOPE
-                && synth->filter_enabled)
-	    || (env_type == GEONKICK_DISTORTION_DRIVE_ENVELOPE
-                && synth->distortion->enabled))
-                synth->buffer_update = true;
+		res = gkick_envelope_add_point(synth->distortion->drive_env, x, y);
+
+        if (res == GEONKICK_OK)
+                gkick_synth_kick_env_changed(synth, env_type);
         gkick_synth_unlock(synth);
-        return GEONKICK_OK;
+        return res;
 }
 
 enum geonkick_error
@@ -981,23 +1519,19 @@ gkick_synth_kick_remove_env_point(struct gkick_synth *synth,
                 return GEONKICK_ERROR;
         }
 
+        enum geonkick_error res = GEONKICK_OK;
         gkick_synth_lock(synth);
         if (env_type == GEONKICK_AMPLITUDE_ENVELOPE)
-                gkick_envelope_remove_point(synth->envelope, index);
+                res = gkick_envelope_remove_point(synth->envelope, index);
         else if (env_type == GEONKICK_FILTER_CUTOFF_ENVELOPE)
-                gkick_envelope_remove_point(synth->filter->cutoff_env, index);
+                res = gkick_envelope_remove_point(synth->filter->cutoff_env, index);
 	else if (env_type == GEONKICK_DISTORTION_DRIVE_ENVELOPE)
-		gkick_envelope_remove_point(synth->distortion->drive_env, index);
+		res = gkick_envelope_remove_point(synth->distortion->drive_env, index);
 
-        if (env_type == GEONKICK_AMPLITUDE_ENVELOPE
-            || (env_type == GEONKICK_FILTER_CUTOFF_ENVELOPE
-                && synth->filter_enabled)
-	    || (env_type == GEONKICK_DISTORTION_DRIVE_ENVELOPE
-                && synth->distortion->enabled)) {
-                synth->buffer_update = true;
-        }
+        if (res == GEONKICK_OK)
+                gkick_synth_kick_env_changed(synth, env_type);
         gkick_synth_unlock(synth);
-        return GEONKICK_OK;
+        return res;
 }
 
 enum geonkick_error
@@ -1012,29 +1546,25 @@ gkick_synth_kick_update_env_point(struct gkick_synth *synth,
                 return GEONKICK_ERROR;
         }
 
+        enum geonkick_error res = GEONKICK_OK;
         gkick_synth_lock(synth);
         if (env_type == GEONKICK_AMPLITUDE_ENVELOPE)
-                gkick_envelope_update_point(synth->envelope,
-                                            index,
-                                            x, y);
+                res = gkick_envelope_update_point(synth->envelope,
+                                                  index,
+                                                  x, y);
         else if (env_type == GEONKICK_FILTER_CUTOFF_ENVELOPE)
-                gkick_envelope_update_point(synth->filter->cutoff_env,
-                                            index,
-                                            x, y);
+                res = gkick_envelope_update_point(synth->filter->cutoff_env,
+                                                  index,
+                                                  x, y);
 	else if (env_type == GEONKICK_DISTORTION_DRIVE_ENVELOPE)
-		gkick_envelope_update_point(synth->distortion->drive_env,
-                                            index,
-                                            x, y);
-
-        if (env_type == GEONKICK_AMPLITUDE_ENVELOPE
-            || (env_type == GEONKICK_FILTER_CUTOFF_ENVELOPE
-                && synth->filter_enabled)
-	    || (env_type == GEONKICK_DISTORTION_DRIVE_ENVELOPE
-                && synth->distortion->enabled)) {
-                synth->buffer_update = true;
-	}
+		res = gkick_envelope_update_point(synth->distortion->drive_env,
+                                                  index,
+                                                  x, y);
+
+        if (res == GEONKICK_OK)
+                gkick_synth_kick_env_changed(synth, env_type);
         gkick_synth_unlock(synth);
-        return GEONKICK_OK;
+        return res;
 }
 
 enum geonkick_error
@@ -1059,7 +1589,7 @@ gkick_synth_set_osc_frequency(struct gkick_synth *synth,
 	osc->frequency = v;
         if (synth->osc_groups[osc_index / GKICK_OSC_GROUP_SIZE]
             && osc->state == GEONKICK_OSC_STATE_ENABLED) {
-                synth->buffer_update = true;
+                gkick_synth_osc_changed(synth, osc_index);
         }
 
 	gkick_synth_unlock(synth);
@@ -1109,7 +1639,7 @@ gkick_synth_set_osc_amplitude(struct gkick_synth *synth,
 
         if (synth->osc_groups[osc_index / GKICK_OSC_GROUP_SIZE]
             && osc->state == GEONKICK_OSC_STATE_ENABLED) {
-                synth->buffer_update = true;
+                gkick_synth_osc_changed(synth, osc_index);
         }
 
 	gkick_synth_unlock(synth);
@@ -1197,137 +1727,118 @@ gkick_synth_process(struct gkick_synth *synth)
 	if (synth == NULL)
 		return GEONKICK_ERROR;
 
+        /**
+         * Take a snapshot of the parameters. The synthesis is done
+         * from the snapshot without locking the synthesizer, so the
+         * setters are never blocked by the synthesis and the synthesis
+         * never sees partially applied parameters.
+         */
 	gkick_synth_lock(synth);
-	synth->buffer_update = false;
-	gkick_buffer_set_size((struct gkick_buffer*)synth->buffer,
-                              synth->buffer_size);
-	gkick_real dt = synth->length / synth->buffer_size;
-	gkick_synth_reset_oscillators(synth);
-	gkick_filter_init(synth->filter);
+        enum geonkick_error res = gkick_synth_take_snapshot(synth);
 	gkick_synth_unlock(synth);
+        if (res != GEONKICK_OK)
+                return res;
 
-	/* Synthesize the percussion into the synthesizer buffer. */
-	size_t i = 0;
-        size_t tries = 0;
-	while (1) {
+        struct gkick_synth_snapshot *snapshot = synth->snapshot;
+        res = gkick_synth_render_prepare(synth->render, snapshot);
+        if (res != GEONKICK_OK)
+                return res;
+
+        size_t size = snapshot->buffer_size;
+        struct gkick_buffer *buffer = (struct gkick_buffer*)synth->buffer;
+        if (buffer->max_size < size) {
                 /**
-                 * Try lock in order not too block the access
-                 * of the synthesizer parameters for too long time.
+                 * The sample rate was increased. Only the buffer of the
+                 * synthesizer is reallocated here, the other buffers
+                 * are replaced gradually when swapped with this one,
+                 * so the audio thread never waits for an allocation.
                  */
-                if (pthread_mutex_trylock(&synth->lock) != 0) {
-                        usleep(50);
-                        /**
-                         * Check how many tries for locking to avoind infinite loop.
-                         * It should be maximum around 30ms.
-                         */
-                        if (++tries > 600)
-                                break;
-                        else
-                                continue;
-                }
-
-		if (gkick_buffer_is_end((struct gkick_buffer*)synth->buffer)) {
-			gkick_synth_unlock(synth);
-			break;
-		} else {
-			gkick_real val = gkick_synth_get_value(synth, (gkick_real)(i * dt));
-			if (isnan(val))
-				val = 0.0f;
-			else if (val > 1.0f)
-				val = 1.0f;
-			else if (val < -1.0f)
-				val = -1.0f;
-			gkick_buffer_push_back((struct gkick_buffer*)synth->buffer, val);
-			i++;
-		}
+                struct gkick_buffer *new_buffer = NULL;
+                gkick_buffer_new(&new_buffer, GEONKICK_MAX_LENGTH * snapshot->sample_rate);
+                if (new_buffer == NULL)
+                        return GEONKICK_ERROR_MEM_ALLOC;
+                gkick_synth_lock(synth);
+                synth->buffer = (char*)new_buffer;
                 gkick_synth_unlock(synth);
-	}
-
-	gkick_synth_lock(synth);
-        if (synth->buffer_callback != NULL && synth->callback_args != NULL) {
-                synth->buffer_callback(synth->callback_args,
-                                       ((struct gkick_buffer*)synth->buffer)->buff,
-                                       synth->buffer_size,
-                                       synth->id);
+                gkick_buffer_free(&buffer);
+                buffer = new_buffer;
         }
+	gkick_buffer_set_size(buffer, size);
+        gkick_buffer_commit(buffer, 0);
+	gkick_real dt = snapshot->length / size;
+        gkick_compressor_init(snapshot->compressor);
+        gkick_distortion_init(snapshot->distortion);
 
         /**
-         * Don't update the output audio buffer if
-         * the synthesizer parameters
-         * were updated during the synthesis.
+         * Publish the buffer to the audio output before the synthesis.
+         * The audio output keeps playing the last complete percussion
+         * until this one is synthesized. If there is none, it plays
+         * the frames as they are committed, so a hit during the synthesis
+         * plays the already synthesized attack without waiting.
          */
-        if (!synth->buffer_update) {
-                gkick_audio_output_lock(synth->output);
-                char* buff = synth->output->updated_buffer;
-                synth->output->updated_buffer = synth->buffer;
-                synth->buffer = buff;
-                gkick_audio_output_unlock(synth->output);
+	gkick_synth_lock(synth);
+        if (synth->version != snapshot->version) {
+                gkick_synth_unlock(synth);
+                return GEONKICK_OK;
         }
+        synth->buffer = (char*)gkick_audio_output_publish_buffer(synth->output, buffer);
 	gkick_synth_unlock(synth);
 
-	return GEONKICK_OK;
-}
-
-gkick_real
-gkick_synth_get_value(struct gkick_synth *synth,
-                      gkick_real t)
-{
-        gkick_real val = 0.0f;
-        gkick_real env_x = 0.0f;
-        gkick_real fm_val = 0.0f;
-        size_t n = synth->oscillators_number;
-        for (size_t i = 0; i < n; i++) {
-                if (synth->osc_groups[i / GKICK_OSC_GROUP_SIZE]
-                    && gkick_osc_enabled(synth->oscillators[i])) {
-                        if (synth->oscillators[i]->is_fm
-                            && i % 3 == 0 && i + 1 < n) {
-                                fm_val = gkick_osc_value(synth->oscillators[i],
-                                                         t,
-                                                         synth->length);
-                                synth->oscillators[i + 1]->fm_input = fm_val;
+	/* Synthesize the percussion into the synthesizer buffer block by block. */
+        _Alignas(GKICK_SYNTH_BUFFER_ALIGNMENT) gkick_real block[GKICK_SYNTH_BLOCK_SIZE];
+	size_t i = 0;
+	while (i < size) {
+                /**
+                 * Cancel the synthesis if the parameters were changed,
+                 * the result would not be used. The dirty flags are kept,
+                 * so the partially synthesized stages are synthesized again
+                 * by the next synthesis that takes the latest parameters.
+                 * The buffer is taken back from the audio output, so the last
+                 * complete percussion keeps playing. If the audio output already
+                 * plays it (there was no complete percussion), the rest of it
+                 * is silenced, so the voices don't wait for frames that will
+                 * never come.
+                 */
+                if (synth->version != snapshot->version) {
+                        gkick_synth_lock(synth);
+                        if (gkick_audio_output_retract_buffer(synth->output, buffer)) {
+                                synth->buffer = (char*)buffer;
                         } else {
-                                gkick_real group_ampl
-                                        = synth->osc_groups_amplitude[i / GKICK_OSC_GROUP_SIZE];
-                                val += group_ampl * gkick_osc_value(synth->oscillators[i],
-                                                                    t,
-                                                                    synth->length);
+                                memset(buffer->buff + i, 0, (size - i) * sizeof(gkick_real));
+                                gkick_buffer_commit(buffer, size);
                         }
-                        gkick_osc_increment_phase(synth->oscillators[i], t, synth->length);
+                        gkick_synth_unlock(synth);
+                        return GEONKICK_OK;
                 }
-        }
-
-        env_x = t / synth->length;
-        val *= synth->amplitude * gkick_envelope_get_value(synth->envelope, env_x);
-        if (synth->filter_enabled)
-                gkick_filter_val(synth->filter, val, &val, env_x);
-
-        int enabled = 0;
-        gkick_distortion_is_enabled(synth->distortion, &enabled);
-        if (enabled)
-                gkick_distortion_val(synth->distortion, val, &val, env_x);
-
-        gkick_compressor_is_enabled(synth->compressor, &enabled);
-        if (enabled)
-                gkick_compressor_val(synth->compressor, val, &val);
 
-        return val;
-}
-
-void
-gkick_synth_reset_oscillators(struct gkick_synth *synth)
-{
-        if (synth == NULL)
-                return;
+                size_t n = size - i;
+                if (n > GKICK_SYNTH_BLOCK_SIZE)
+                        n = GKICK_SYNTH_BLOCK_SIZE;
+                gkick_synth_render_block(synth->render, snapshot, i, n, dt, block);
+                for (size_t j = 0; j < n; j++) {
+                        gkick_real val = block[j];
+                        if (isnan(val))
+                                val = 0.0f;
+                        else if (val > 1.0f)
+                                val = 1.0f;
+                        else if (val < -1.0f)
+                                val = -1.0f;
+                        buffer->buff[i + j] = val;
+                }
+                i += n;
+                gkick_buffer_commit(buffer, i);
+	}
+        gkick_synth_render_done(synth->render);
+        gkick_audio_output_complete_buffer(synth->output, buffer);
 
-        for (size_t i = 0; i < synth->oscillators_number; i++) {
-                struct gkick_oscillator *osc = synth->oscillators[i];
-                osc->phase = osc->initial_phase;
-                osc->fm_input = 0.0f;
-                osc->seedp = osc->seed;
-                gkick_filter_init(osc->filter);
-                if (osc->sample != NULL)
-                        gkick_buffer_reset(osc->sample);
+        if (synth->buffer_callback != NULL && synth->callback_args != NULL) {
+                synth->buffer_callback(synth->callback_args,
+                                       buffer->buff,
+                                       size,
+                                       synth->id);
         }
+
+	return GEONKICK_OK;
 }
 
 int
@@ -1361,7 +1872,7 @@ gkick_synth_set_osc_filter_type(struct gkick_synth *synth,
         if (osc->filter_enabled
             && synth->osc_groups[osc_index / GKICK_OSC_GROUP_SIZE]
             && osc->state == GEONKICK_OSC_STATE_ENABLED) {
-                synth->buffer_update = true;
+                gkick_synth_osc_changed(synth, osc_index);
         }
 
         gkick_synth_unlock(synth);
@@ -1418,7 +1929,7 @@ gkick_synth_set_osc_filter_cutoff(struct gkick_synth *synth,
         if (osc->filter_enabled
             && synth->osc_groups[osc_index / GKICK_OSC_GROUP_SIZE]
             && osc->state == GEONKICK_OSC_STATE_ENABLED) {
-                synth->buffer_update = true;
+                gkick_synth_osc_changed(synth, osc_index);
         }
 
         gkick_synth_unlock(synth);
@@ -1474,7 +1985,7 @@ gkick_synth_set_osc_filter_factor(struct gkick_synth *synth,
         if (osc->filter_enabled
             && synth->osc_groups[osc_index / GKICK_OSC_GROUP_SIZE]
             && osc->state == GEONKICK_OSC_STATE_ENABLED) {
-                synth->buffer_update = true;
+                gkick_synth_osc_changed(synth, osc_index);
         }
         gkick_synth_unlock(synth);
         return res;
@@ -1528,7 +2039,7 @@ gkick_synth_osc_enable_filter(struct gkick_synth *synth,
         osc->filter_enabled = enable;
         if (synth->osc_groups[osc_index / GKICK_OSC_GROUP_SIZE]
             && osc->state == GEONKICK_OSC_STATE_ENABLED) {
-                synth->buffer_update = true;
+                gkick_synth_osc_changed(synth, osc_index);
         }
 
         gkick_synth_unlock(synth);
@@ -1563,9 +2074,18 @@ enum geonkick_error
 gkick_synth_compressor_enable(struct gkick_synth *synth,
                               int enable)
 {
-        synth->buffer_update = true;
-        return gkick_compressor_enable(synth->compressor,
-                                       enable);
+        /**
+         * Apply the state before the version is changed, both under
+         * the lock, so a snapshot with the new version never has the
+         * old state.
+         */
+        gkick_synth_lock(synth);
+        enum geonkick_error res = gkick_compressor_enable(synth->compressor,
+                                                          enable);
+        if (res == GEONKICK_OK)
+                gkick_synth_params_changed(synth);
+        gkick_synth_unlock(synth);
+        return res;
 }
 
 enum geonkick_error
@@ -1587,7 +2107,7 @@ gkick_synth_compressor_set_attack(struct gkick_synth *synth,
         gkick_compressor_is_enabled(synth->compressor,
                                     &enabled);
         if (res == GEONKICK_OK && enabled)
-                synth->buffer_update = true;
+                gkick_synth_params_changed(synth);
         return res;
 }
 
@@ -1610,7 +2130,7 @@ gkick_synth_compressor_set_release(struct gkick_synth *synth,
         gkick_compressor_is_enabled(synth->compressor,
                                     &enabled);
         if (res == GEONKICK_OK && enabled)
-                synth->buffer_update = true;
+                gkick_synth_params_changed(synth);
         return res;
 }
 
@@ -1633,7 +2153,7 @@ gkick_synth_compressor_set_threshold(struct gkick_synth *synth,
         gkick_compressor_is_enabled(synth->compressor,
                                     &enabled);
         if (res == GEONKICK_OK && enabled)
-                synth->buffer_update = true;
+                gkick_synth_params_changed(synth);
         return res;
 }
 
@@ -1654,7 +2174,7 @@ gkick_synth_compressor_set_ratio(struct gkick_synth *synth,
         int enabled = 0;
         gkick_compressor_is_enabled(synth->compressor, &enabled);
         if (res == GEONKICK_OK && enabled)
-                synth->buffer_update = true;
+                gkick_synth_params_changed(synth);
         return res;
 }
 
@@ -1675,7 +2195,7 @@ gkick_synth_compressor_set_knee(struct gkick_synth *synth,
         int enabled = false;
         gkick_compressor_is_enabled(synth->compressor, &enabled);
         if (res == GEONKICK_OK && enabled)
-                synth->buffer_update = true;
+                gkick_synth_params_changed(synth);
         return res;
 }
 
@@ -1695,7 +2215,7 @@ gkick_synth_compressor_set_makeup(struct gkick_synth *synth,
         int enabled;
         gkick_compressor_is_enabled(synth->compressor, &enabled);
         if (res == GEONKICK_OK && enabled)
-                synth->buffer_update = true;
+                gkick_synth_params_changed(synth);
         return res;
 }
 
@@ -1711,9 +2231,13 @@ enum geonkick_error
 gkick_synth_distortion_enable(struct gkick_synth *synth,
                               int enable)
 {
-	synth->buffer_update = true;
-        return gkick_distortion_enable(synth->distortion,
-                                       enable);
+        gkick_synth_lock(synth);
+        enum geonkick_error res = gkick_distortion_enable(synth->distortion,
+                                                          enable);
+        if (res == GEONKICK_OK)
+                gkick_synth_params_changed(synth);
+        gkick_synth_unlock(synth);
+        return res;
 }
 
 enum geonkick_error
@@ -1734,7 +2258,7 @@ gkick_synth_distortion_set_in_limiter(struct gkick_synth *synth,
         gkick_distortion_is_enabled(synth->distortion,
                                           &enabled);
         if (enabled)
-                synth->buffer_update = true;
+                gkick_synth_params_changed(synth);
         return GEONKICK_OK;
 }
 
@@ -1754,7 +2278,7 @@ gkick_synth_distortion_set_volume(struct gkick_synth *synth, gkick_real volume)
         res = gkick_distortion_set_volume(synth->distortion, volume);
         gkick_distortion_is_enabled(synth->distortion, &enabled);
         if (res == GEONKICK_OK && enabled)
-                synth->buffer_update = true;
+                gkick_synth_params_changed(synth);
         return res;
 }
 
@@ -1775,7 +2299,7 @@ gkick_synth_distortion_set_drive(struct gkick_synth *synth,
         res = gkick_distortion_set_drive(synth->distortion, drive);
         gkick_distortion_is_enabled(synth->distortion, &enabled);
         if (res == GEONKICK_OK && enabled)
-                synth->buffer_update = true;
+                gkick_synth_params_changed(synth);
         return res;
 }
 
@@ -1786,6 +2310,26 @@ gkick_synth_distortion_get_drive(struct gkick_synth *synth,
         return gkick_distortion_get_drive(synth->distortion, drive);
 }
 
+enum geonkick_error
+gkick_synth_distortion_set_oversampling(struct gkick_synth *synth,
+                                        int factor)
+{
+        enum geonkick_error res;
+        int enabled;
+        res = gkick_distortion_set_oversampling(synth->distortion, factor);
+        gkick_distortion_is_enabled(synth->distortion, &enabled);
+        if (res == GEONKICK_OK && enabled)
+                gkick_synth_params_changed(synth);
+        return res;
+}
+
+enum geonkick_error
+gkick_synth_distortion_get_oversampling(struct gkick_synth *synth,
+                                        int *factor)
+{
+        return gkick_distortion_get_oversampling(synth->distortion, factor);
+}
+
 enum geonkick_error
 gkick_synth_enable_group(struct gkick_synth *synth,
                          size_t index,
@@ -1793,7 +2337,8 @@ gkick_synth_enable_group(struct gkick_synth *synth,
 {
         gkick_synth_lock(synth);
         synth->osc_groups[index] = enable;
-        synth->buffer_update = true;
+        for (size_t i = 0; i < GKICK_OSC_GROUP_SIZE; i++)
+                gkick_synth_osc_changed(synth, index * GKICK_OSC_GROUP_SIZE + i);
         gkick_synth_unlock(synth);
         return GEONKICK_OK;
 }
@@ -1816,7 +2361,7 @@ geonkick_synth_group_set_amplitude(struct gkick_synth *synth,
 {
         gkick_synth_lock(synth);
         synth->osc_groups_amplitude[index] = amplitude;
-        synth->buffer_update = true;
+        gkick_synth_stage_changed(synth, GKICK_SYNTH_STAGE_MIX);
         gkick_synth_unlock(synth);
         return GEONKICK_OK;
 }
@@ -1847,12 +2392,15 @@ geonkick_synth_set_osc_sample(struct gkick_synth *synth,
 		return GEONKICK_ERROR;
 	}
 
+        size_t max_size = GEONKICK_MAX_LENGTH * synth->sample_rate;
+        if (osc->sample != NULL && osc->sample->max_size < max_size)
+                gkick_buffer_free(&osc->sample);
         if (osc->sample == NULL)
-                gkick_buffer_new(&osc->sample, GEONKICK_MAX_KICK_BUFFER_SIZE);
+                gkick_buffer_new(&osc->sample, max_size);
         gkick_buffer_set_data(osc->sample, data, size);
         if (synth->osc_groups[osc_index / GKICK_OSC_GROUP_SIZE]
             && osc->state == GEONKICK_OSC_STATE_ENABLED)
-                synth->buffer_update = true;
+                gkick_synth_osc_changed(synth, osc_index);
         gkick_synth_unlock(synth);
         return GEONKICK_OK;
 }
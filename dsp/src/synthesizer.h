@@ -25,12 +25,105 @@
 #define GKICK_SYNTHESIZER_H
 
 #include "geonkick_internal.h"
+#include "envelope.h"
 #include "compressor.h"
 #include "distortion.h"
 #include "audio_output.h"
 
 #include <stdatomic.h>
 
+/* Number of frames the synthesizer renders at once. */
+#define GKICK_SYNTH_BLOCK_SIZE 256
+
+/* Alignment in bytes of the synthesis buffers. */
+#define GKICK_SYNTH_BUFFER_ALIGNMENT 64
+
+/* Dirty flags of all the oscillators. */
+#define GKICK_SYNTH_OSC_ALL ((1u << (GKICK_OSC_GROUPS_NUMBER * GKICK_OSC_GROUP_SIZE)) - 1)
+
+/**
+ * Stages of the synthesis which results are cached between
+ * the synthesis and synthesized again only when changed.
+ */
+enum gkick_synth_stage {
+        /* Mix of the oscillators with the kick amplitude envelope. */
+        GKICK_SYNTH_STAGE_MIX    = 1,
+        /**
+         * Kick filter applied on the mix. The output of this stage
+         * is the input of the kick effects, so the changes of
+         * the distortion and compressor synthesize only the effects.
+         */
+        GKICK_SYNTH_STAGE_FILTER = 2,
+        GKICK_SYNTH_STAGE_ALL    = GKICK_SYNTH_STAGE_MIX | GKICK_SYNTH_STAGE_FILTER
+};
+
+/**
+ * Read-only copy of the synthesizer parameters the synthesis
+ * is done from. It is taken under the synthesizer lock at the
+ * beginning of the synthesis and after that it is accessed only
+ * by the worker, so the setters can build the next version
+ * of the parameters without blocking the synthesis.
+ */
+struct gkick_synth_snapshot {
+        /* Parameters version the snapshot was taken from. */
+        uint64_t version;
+        size_t buffer_size;
+        gkick_real sample_rate;
+        gkick_real length;
+        gkick_real amplitude;
+        bool osc_groups[GKICK_OSC_GROUPS_NUMBER];
+        gkick_real osc_groups_amplitude[GKICK_OSC_GROUPS_NUMBER];
+        struct gkick_oscillator **oscillators;
+        size_t oscillators_number;
+        struct gkick_filter *filter;
+        int filter_enabled;
+        struct gkick_compressor *compressor;
+        struct gkick_distortion *distortion;
+        struct gkick_envelope *envelope;
+};
+
+/**
+ * Buffers and state the worker uses during the synthesis.
+ */
+struct gkick_synth_render {
+        /* Synthesis state of the oscillators. */
+        struct gkick_osc_state *osc_state;
+
+        /**
+         * Signal of every enabled oscillator for the whole
+         * percussion. Allocated only for the used oscillators.
+         */
+        gkick_real *osc_buffers[GKICK_OSC_GROUPS_NUMBER * GKICK_OSC_GROUP_SIZE];
+        /* Allocated size in frames of every oscillator buffer. */
+        size_t osc_buffers_size[GKICK_OSC_GROUPS_NUMBER * GKICK_OSC_GROUP_SIZE];
+
+        /* Mix of the oscillators before the kick effects. */
+        gkick_real *mix_buffer;
+        size_t mix_buffer_size;
+
+        /**
+         * Mix after the kick filter, the input of the kick effects.
+         * Used only when the kick filter is enabled.
+         */
+        gkick_real *filter_buffer;
+        size_t filter_buffer_size;
+
+        /**
+         * Oscillators and stages changed since
+         * the last complete synthesis.
+         */
+        unsigned int osc_dirty;
+        unsigned int stages_dirty;
+
+        /**
+         * Positions on the kick amplitude, filter cutoff
+         * and distortion drive envelopes.
+         */
+        struct gkick_envelope_cursor envelope_cursor;
+        struct gkick_envelope_cursor cutoff_cursor;
+        struct gkick_envelope_cursor drive_cursor;
+};
+
 struct gkick_synth {
       	atomic_size_t id;
         char name[30];
@@ -54,6 +147,9 @@ struct gkick_synth {
         /* Time length of the kick in seconds. */
         gkick_real length;
 
+        /* Sample rate of the synthesis. */
+        gkick_real sample_rate;
+
         /* Kick general filter */
         struct gkick_filter *filter;
         int filter_enabled;
@@ -70,9 +166,26 @@ struct gkick_synth {
         /* To update or not the buffer. */
         atomic_bool buffer_update;
 
+        /**
+         * Version of the synthesizer parameters.
+         * Incremented by every parameter change.
+         */
+        _Atomic uint64_t version;
+
+        /* Changed oscillators and stages not taken by the worker yet. */
+        atomic_uint osc_dirty;
+        atomic_uint stages_dirty;
+
+        /* Parameters the worker is doing the synthesis from. */
+        struct gkick_synth_snapshot *snapshot;
+
+        /* Buffers and state used by the worker for the synthesis. */
+        struct gkick_synth_render *render;
+
         /**
          * Kick smaples buffer where the synthesizer is doing the synthesis.
-         * It is swaped with one of the oudio output buffers atomically.
+         * It is published to the audio output at the beginning of the
+         * synthesis, the audio output gives back a buffer that is not played.
          */
         char* _Atomic buffer;
         /* Kick buffer size. */
@@ -108,6 +221,62 @@ gkick_synth_unlock(struct gkick_synth *synth);
 enum geonkick_error
 gkick_synth_create_oscillators(struct gkick_synth *synth);
 
+enum geonkick_error
+gkick_synth_snapshot_new(struct gkick_synth_snapshot **snapshot,
+                         size_t oscillators_number);
+
+void
+gkick_synth_snapshot_free(struct gkick_synth_snapshot **snapshot);
+
+enum geonkick_error
+gkick_synth_take_snapshot(struct gkick_synth *synth);
+
+void
+gkick_synth_params_changed(struct gkick_synth *synth);
+
+void
+gkick_synth_osc_changed(struct gkick_synth *synth, size_t index);
+
+void
+gkick_synth_stage_changed(struct gkick_synth *synth,
+                          enum gkick_synth_stage stage);
+
+void
+gkick_synth_kick_env_changed(struct gkick_synth *synth,
+                             enum geonkick_envelope_type env_type);
+
+enum geonkick_error
+gkick_synth_render_new(struct gkick_synth_render **render);
+
+void
+gkick_synth_render_free(struct gkick_synth_render **render);
+
+enum geonkick_error
+gkick_synth_render_prepare(struct gkick_synth_render *render,
+                           struct gkick_synth_snapshot *snapshot);
+
+gkick_real*
+gkick_synth_render_alloc(size_t size);
+
+void
+gkick_synth_render_done(struct gkick_synth_render *render);
+
+void
+gkick_synth_render_block(struct gkick_synth_render *render,
+                         struct gkick_synth_snapshot *snapshot,
+                         size_t offset,
+                         size_t size,
+                         gkick_real dt,
+                         gkick_real *out);
+
+bool
+gkick_synth_osc_is_rendered(struct gkick_synth_snapshot *snapshot,
+                            size_t index);
+
+bool
+gkick_synth_osc_is_fm_source(struct gkick_synth_snapshot *snapshot,
+                             size_t index);
+
 enum geonkick_error
 gkick_synth_get_oscillators_number(struct gkick_synth *synth,
 				   size_t *number);
@@ -141,6 +310,16 @@ gkick_synth_osc_is_fm(struct gkick_synth *synth,
                       size_t index,
 		      bool *is_fm);
 
+enum geonkick_error
+gkick_synth_osc_set_band_limited(struct gkick_synth *synth,
+                                 size_t index,
+                                 bool band_limited);
+
+enum geonkick_error
+gkick_synth_osc_is_band_limited(struct gkick_synth *synth,
+                                size_t index,
+                                bool *band_limited);
+
 enum geonkick_error
 gkick_synth_osc_envelope_points(struct gkick_synth *synth,
                                 int osc_index,
@@ -214,6 +393,10 @@ enum geonkick_error
 gkick_synth_set_length(struct gkick_synth *synth,
 		       gkick_real len);
 
+enum geonkick_error
+gkick_synth_set_sample_rate(struct gkick_synth *synth,
+                            gkick_real rate);
+
 enum geonkick_error
 gkick_synth_kick_set_amplitude(struct gkick_synth *synth,
 			       gkick_real amplitude);
@@ -319,12 +502,6 @@ void gkick_synth_set_output(struct gkick_synth *synth,
 enum geonkick_error
 gkick_synth_process(struct gkick_synth *synth);
 
-gkick_real
-gkick_synth_get_value(struct gkick_synth *synth,
-                      gkick_real t);
-
-void
-gkick_synth_reset_oscillators(struct gkick_synth *synth);
 
 int
 gkick_synth_is_update_buffer(struct gkick_synth *synth);
@@ -456,6 +633,14 @@ enum geonkick_error
 gkick_synth_distortion_get_drive(struct gkick_synth *synth,
 				 gkick_real *drive);
 
+enum geonkick_error
+gkick_synth_distortion_set_oversampling(struct gkick_synth *synth,
+                                        int factor);
+
+enum geonkick_error
+gkick_synth_distortion_get_oversampling(struct gkick_synth *synth,
+                                        int *factor);
+
 enum geonkick_error
 gkick_synth_enable_group(struct gkick_synth *synth,
 			 size_t index,
@@ -40,6 +40,7 @@
 #include <vector>
 #include <memory>
 #include <atomic>
+#include <algorithm>
 
 #define GEONKICK_URI "http://geontime.com/geonkick"
 #define GEONKICK_URI_UI "http://geontime.com/geonkick#ui"
@@ -164,31 +165,30 @@ class GeonkickLv2Plugin
         {
                 if (!midiIn)
                         return;
-                auto it = lv2_atom_sequence_begin(&midiIn->body);
-                for (auto i = 0; i < nsamples; i++) {
-                        while (it->time.frames == i
-                               && !lv2_atom_sequence_is_end(&midiIn->body, midiIn->atom.size, it)) {
-                                const uint8_t* const msg = (const uint8_t*)(it + 1);
-                                switch (lv2_midi_message_type(msg))
-                                {
-                                case LV2_MIDI_MSG_NOTE_ON:
-                                        geonkickApi->setKeyPressed(true, msg[1], msg[2]);
-                                        break;
-                                case LV2_MIDI_MSG_NOTE_OFF:
-                                        geonkickApi->setKeyPressed(false, msg[1], msg[2]);
-                                        break;
-                                default:
-                                        break;
-                                }
-                                it = lv2_atom_sequence_next(it);
+                auto nChannels = std::min(geonkickApi->numberOfChannels(), outputChannels.size());
+                size_t nFrames = nsamples;
+                LV2_ATOM_SEQUENCE_FOREACH(midiIn, ev) {
+                        const uint8_t* const msg = (const uint8_t*)(ev + 1);
+                        gkick_note_event event;
+                        event.offset = ev->time.frames;
+                        event.note = msg[1];
+                        event.velocity = msg[2];
+                        switch (lv2_midi_message_type(msg))
+                        {
+                        case LV2_MIDI_MSG_NOTE_ON:
+                                event.state = GKICK_KEY_STATE_PRESSED;
+                                break;
+                        case LV2_MIDI_MSG_NOTE_OFF:
+                                event.state = GKICK_KEY_STATE_RELEASED;
+                                break;
+                        default:
+                                continue;
                         }
 
-                        auto nChannels = geonkickApi->numberOfChannels();
-                        for (decltype(nChannels) ch = 0; ch < nChannels; ch++) {
-                                if (outputChannels[ch])
-                                        outputChannels[ch][i] = geonkickApi->getAudioFrame(ch);
-                        }
+                        geonkickApi->addNoteEvent(outputChannels.data(), nChannels,
+                                                  nFrames, event);
                 }
+                geonkickApi->renderBlock(outputChannels.data(), nChannels, nFrames);
 
                 if (isKickUpdated()) {
                         notifyHost();
@@ -365,6 +365,7 @@ static LV2_Handle gkick_instantiate(const LV2_Descriptor*     descriptor,
                 delete geonkickLv2PLugin;
                 return NULL;
         }
+        geonkickLv2PLugin->getApi()->setSampleRate(rate);
 
         const LV2_Feature *feature;
         while ((feature = *features)) {
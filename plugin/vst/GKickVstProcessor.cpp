@@ -59,6 +59,7 @@ GKickVstProcessor::initialize(FUnknown* context)
         }
 
         auto nChannels = geonkickApi->numberOfChannels();
+        channelBuffers.resize(nChannels, nullptr);
         for (decltype(nChannels) i = 0; i < nChannels; i++) {
                 std::wstring_convert<std::codecvt_utf8<char16_t>,char16_t> convert;
                 std::u16string str16 = convert.from_bytes(std::string("Out " + std::to_string(i)));
@@ -83,6 +84,7 @@ GKickVstProcessor::setBusArrangements(Vst::SpeakerArrangement* inputs,
 tresult PLUGIN_API
 GKickVstProcessor::setupProcessing(Vst::ProcessSetup& setup)
 {
+        geonkickApi->setSampleRate(setup.sampleRate);
         return Vst::SingleComponentEffect::setupProcessing(setup);
 }
 
@@ -96,43 +98,40 @@ tresult PLUGIN_API
 GKickVstProcessor::process(Vst::ProcessData& data)
 {
         if (data.numSamples > 0) {
+                auto nChannels = std::min(channelBuffers.size(),
+                                          static_cast<size_t>(data.numOutputs));
+                for (decltype(nChannels) ch = 0; ch < nChannels; ch++)
+                        channelBuffers[ch] = data.outputs[ch].channelBuffers32[0];
+
+                size_t nFrames = data.numSamples;
                 auto events = data.inputEvents;
-                auto nEvents = events->getEventCount();
-                auto eventIndex = 0;
-                Vst::Event event;
-                auto res = events->getEvent(eventIndex, event);
-                for (decltype(data.numSamples) i = 0; i < data.numSamples; i++) {
-                        if (res != kResultOk)
-                                res = events->getEvent(eventIndex, event);
-                        while (res == kResultOk && event.sampleOffset == i && eventIndex < nEvents) {
-                                switch (event.type) {
-                                case Vst::Event::kNoteOnEvent:
-                                        geonkickApi->setKeyPressed(true,
-                                                                   event.noteOn.pitch,
-                                                                   127 * event.noteOn.velocity);
-                                        break;
-
-                                case Vst::Event::kNoteOffEvent:
-                                        geonkickApi->setKeyPressed(false,
-                                                                   event.noteOff.pitch,
-                                                                   127 * event.noteOff.velocity);
-                                        break;
-                                default:
-                                        break;
-                                }
-
-                                eventIndex++;
-                                if (eventIndex < nEvents)
-                                        res = events->getEvent(eventIndex, event);
+                auto nEvents = events ? events->getEventCount() : 0;
+                for (decltype(nEvents) i = 0; i < nEvents; i++) {
+                        Vst::Event event;
+                        if (events->getEvent(i, event) != kResultOk)
+                                continue;
+
+                        gkick_note_event noteEvent;
+                        noteEvent.offset = event.sampleOffset > 0 ? event.sampleOffset : 0;
+                        switch (event.type) {
+                        case Vst::Event::kNoteOnEvent:
+                                noteEvent.state = GKICK_KEY_STATE_PRESSED;
+                                noteEvent.note = event.noteOn.pitch;
+                                noteEvent.velocity = 127 * event.noteOn.velocity;
+                                break;
+                        case Vst::Event::kNoteOffEvent:
+                                noteEvent.state = GKICK_KEY_STATE_RELEASED;
+                                noteEvent.note = event.noteOff.pitch;
+                                noteEvent.velocity = 127 * event.noteOff.velocity;
+                                break;
+                        default:
+                                continue;
                         }
 
-                        auto nChannels = geonkickApi->numberOfChannels();
-                        nChannels = std::min(nChannels, static_cast<decltype(nChannels)>(data.numOutputs));
-                        for (decltype(nChannels) ch = 0; ch < nChannels; ch++) {
-                                if (data.outputs[ch].channelBuffers32[0])
-                                        data.outputs[ch].channelBuffers32[0][i] = geonkickApi->getAudioFrame(ch);
-                        }
+                        geonkickApi->addNoteEvent(channelBuffers.data(), nChannels,
+                                                  nFrames, noteEvent);
                 }
+                geonkickApi->renderBlock(channelBuffers.data(), nChannels, nFrames);
 	}
 
         return kResultOk;
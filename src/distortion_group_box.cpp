@@ -33,6 +33,8 @@ RK_DECLARE_IMAGE_RC(distortion_enable_active);
 RK_DECLARE_IMAGE_RC(distortion_in_limiter);
 RK_DECLARE_IMAGE_RC(distortion_volume_label);
 RK_DECLARE_IMAGE_RC(distortion_drive_label);
+RK_DECLARE_IMAGE_RC(checkbox_checked_10x10);
+RK_DECLARE_IMAGE_RC(checkbox_unchecked_10x10);
 
 DistortionGroupBox::DistortionGroupBox(GeonkickApi *api, GeonkickWidget *parent)
         : GeonkickGroupBox(parent)
@@ -40,8 +42,9 @@ DistortionGroupBox::DistortionGroupBox(GeonkickApi *api, GeonkickWidget *parent)
         , volumeSlider{nullptr}
         , driveSlider{nullptr}
         , distortionCheckbox{nullptr}
+        , oversamplingButtons{nullptr, nullptr, nullptr}
 {
-        setFixedSize(110, 63);
+        setFixedSize(140, 63);
         distortionCheckbox = new GeonkickButton(this);
 	distortionCheckbox->setSize(77, 12);
 	distortionCheckbox->setCheckable(true);
@@ -54,11 +57,12 @@ DistortionGroupBox::DistortionGroupBox(GeonkickApi *api, GeonkickWidget *parent)
         int sliderH = 12;
         int yoffset = 2;
         int labelD  = 5;
+        int sliderX = 45;
 
         // In limiter
         inLimiterSlider = new GeonkickSlider(this);
         inLimiterSlider->setFixedSize(sliderW, sliderH);
-        inLimiterSlider->setPosition(width() / 2 + labelD / 2 - 12, yoffset + (height() - sliderH) / 3);
+        inLimiterSlider->setPosition(sliderX, yoffset + (height() - sliderH) / 3);
         inLimiterSlider->onSetValue(50);
         RK_ACT_BIND(inLimiterSlider, valueUpdated, RK_ACT_ARGS(int val), this, setInLimiter(val));
         auto inLimiterLabel = new RkLabel(this);
@@ -70,7 +74,7 @@ DistortionGroupBox::DistortionGroupBox(GeonkickApi *api, GeonkickWidget *parent)
         // Volume
         volumeSlider = new GeonkickSlider(this);
         volumeSlider->setFixedSize(sliderW, sliderH);
-        volumeSlider->setPosition(width() / 2 + labelD / 2 - 12, yoffset + (height() - sliderH) / 3 + sliderH + 4);
+        volumeSlider->setPosition(sliderX, yoffset + (height() - sliderH) / 3 + sliderH + 4);
         volumeSlider->onSetValue(50);
         RK_ACT_BIND(volumeSlider, valueUpdated, RK_ACT_ARGS(int val), this, setVolume(val));
         auto volumeLabel = new RkLabel(this);
@@ -82,16 +86,47 @@ DistortionGroupBox::DistortionGroupBox(GeonkickApi *api, GeonkickWidget *parent)
         // Drive
         driveSlider = new GeonkickSlider(this);
         driveSlider->setFixedSize(sliderW, sliderH);
-        driveSlider->setPosition(width() / 2 + labelD / 2 - 12, yoffset + (height() - sliderH) / 3 + 2 * sliderH + 8);
+        driveSlider->setPosition(sliderX, yoffset + (height() - sliderH) / 3 + 2 * sliderH + 8);
         RK_ACT_BIND(driveSlider, valueUpdated, RK_ACT_ARGS(int val), this, setDrive(val));
         auto driveLabel = new RkLabel(this);
         driveLabel->show();
         driveLabel->setImage(RkImage(24, 8, RK_IMAGE_RC(distortion_drive_label)));
         driveLabel->setFixedSize(24, 8);
         driveLabel->setPosition(driveSlider->x() - driveLabel->width() - labelD, driveSlider->y());
+
+        // Oversampling factors 1x, 2x and 4x
+        for (auto i = 0; i < 3; i++) {
+                oversamplingButtons[i] = new GeonkickButton(this);
+                oversamplingButtons[i]->setFixedSize(10, 10);
+                oversamplingButtons[i]->setPosition(sliderX + sliderW + 8,
+                                                    yoffset + (height() - sliderH) / 3
+                                                    + i * (sliderH + 4) + 1);
+                oversamplingButtons[i]->setPressedImage(RkImage(10, 10, RK_IMAGE_RC(checkbox_checked_10x10)));
+                oversamplingButtons[i]->setUnpressedImage(RkImage(10, 10, RK_IMAGE_RC(checkbox_unchecked_10x10)));
+                RK_ACT_BIND(oversamplingButtons[i], toggled, RK_ACT_ARGS(bool b), this, setOversampling(i, b));
+                auto oversamplingLabel = new RkLabel(this, std::to_string(1 << i) + "x");
+                oversamplingLabel->setFixedSize(14, 10);
+                oversamplingLabel->setTextColor({210, 226, 226, 160});
+                oversamplingLabel->setBackgroundColor(background());
+                oversamplingLabel->setPosition(oversamplingButtons[i]->x()
+                                               + oversamplingButtons[i]->width() + 2,
+                                               oversamplingButtons[i]->y());
+                oversamplingLabel->show();
+        }
         show();
 }
 
+void DistortionGroupBox::setOversampling(int index, bool pressed)
+{
+        if (pressed) {
+                for (auto i = 0; i < 3; i++) {
+                        if (i != index)
+                                oversamplingButtons[i]->setPressed(false);
+                }
+                geonkickApi->setDistortionOversampling(1 << index);
+        }
+}
+
 void DistortionGroupBox::setInLimiter(int val)
 {
         double logVal = -60 * (1.0 - (static_cast<double>(val) / 100));
@@ -141,4 +176,9 @@ void DistortionGroupBox::updateGui()
         else
                 distortion = 20 * log10(distortion);
         driveSlider->onSetValue(100 * distortion / 36);
+
+        // Oversampling
+        auto factor = geonkickApi->getDistortionOversampling();
+        for (auto i = 0; i < 3; i++)
+                oversamplingButtons[i]->setPressed((1 << i) == factor);
 }
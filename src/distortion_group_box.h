@@ -41,6 +41,7 @@ class DistortionGroupBox: public GeonkickGroupBox
         void setVolume(int val);
         void setDrive(int val);
         void setInLimiter(int val);
+        void setOversampling(int index, bool pressed);
 
  private:
         GeonkickApi *geonkickApi;
@@ -48,6 +49,7 @@ class DistortionGroupBox: public GeonkickGroupBox
         GeonkickSlider *inLimiterSlider;
         GeonkickSlider *driveSlider;
         GeonkickButton *distortionCheckbox;
+        GeonkickButton *oversamplingButtons[3];
 };
 
 #endif // GEONKICK_DISTORTION_WIDGET_H
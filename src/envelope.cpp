@@ -367,6 +367,10 @@ void Envelope::setPoints(const std::vector<RkRealPoint> &points)
 
 void Envelope::addPoint(const RkPoint &point)
 {
+        /* The synthesizer envelope can't have more points. */
+        if (envelopePoints.size() >= GEONKICK_MAX_ENVELOPE_POINTS)
+                return;
+
         auto scaledPoint = scaleDown(point);
         if (scaledPoint.y() < 0)
                 scaledPoint.setY(0);
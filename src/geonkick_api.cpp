@@ -43,7 +43,9 @@ GeonkickApi::GeonkickApi()
         , kitName{"Unknown"}
         , kitAuthor{"Author"}
         , clipboardPercussion{nullptr}
+        , renderedFrames{0}
 {
+        noteEvents.reserve(256);
 }
 
 GeonkickApi::~GeonkickApi()
@@ -105,6 +107,8 @@ std::shared_ptr<PercussionState> GeonkickApi::getDefaultPercussionState()
         state->setId(0);
         state->setPlayingKey(-1);
         state->setChannel(0);
+        state->setPolyphony(GEONKICK_DEFAULT_POLYPHONY);
+        state->setVoiceStealing(VoiceStealing::Oldest);
         state->setLimiterValue(1.0);
         state->tuneOutput(false);
         state->setKickLength(300);
@@ -130,6 +134,7 @@ std::shared_ptr<PercussionState> GeonkickApi::getDefaultPercussionState()
         state->setDistortionVolume(0.1);
         state->setDistortionInLimiter(1.0);
         state->setDistortionDrive(1.0);
+        state->setDistortionOversampling(1);
 
         std::vector<GeonkickApi::OscillatorType> oscillators = {
                 GeonkickApi::OscillatorType::Oscillator1,
@@ -185,6 +190,8 @@ void GeonkickApi::setPercussionState(const std::shared_ptr<PercussionState> &sta
         setPercussionName(state->getId(), state->getName());
         setPercussionPlayingKey(state->getId(), state->getPlayingKey());
         setPercussionChannel(state->getId(), state->getChannel());
+        setPercussionPolyphony(state->getId(), state->getPolyphony());
+        setPercussionVoiceStealing(state->getId(), state->getVoiceStealing());
         for (auto i = 0; i < 3; i++) {
                 enbaleLayer(static_cast<Layer>(i), state->isLayerEnabled(static_cast<Layer>(i)));
                 setLayerAmplitude(static_cast<Layer>(i), state->getLayerAmplitude(static_cast<Layer>(i)));
@@ -219,6 +226,7 @@ void GeonkickApi::setPercussionState(const std::shared_ptr<PercussionState> &sta
         setDistortionInLimiter(state->getDistortionInLimiter());
         setDistortionVolume(state->getDistortionVolume());
         setDistortionDrive(state->getDistortionDrive());
+        setDistortionOversampling(state->getDistortionOversampling());
 
         geonkick_set_current_percussion(geonkickApi, currentId);
         geonkick_enable_synthesis(geonkickApi, true);
@@ -257,6 +265,8 @@ std::shared_ptr<PercussionState> GeonkickApi::getPercussionState() const
         state->tuneOutput(isAudioOutputTuned(state->getId()));
         state->setPlayingKey(getPercussionPlayingKey(state->getId()));
         state->setChannel(getPercussionChannel(state->getId()));
+        state->setPolyphony(getPercussionPolyphony(state->getId()));
+        state->setVoiceStealing(getPercussionVoiceStealing(state->getId()));
         for (int i = 0; i < 3; i++) {
                 state->setLayerEnabled(static_cast<Layer>(i), isLayerEnabled(static_cast<Layer>(i)));
                 state->setLayerAmplitude(static_cast<Layer>(i), getLayerAmplitude(static_cast<Layer>(i)));
@@ -290,6 +300,7 @@ std::shared_ptr<PercussionState> GeonkickApi::getPercussionState() const
         state->setDistortionInLimiter(getDistortionInLimiter());
         state->setDistortionVolume(getDistortionVolume());
         state->setDistortionDrive(getDistortionDrive());
+        state->setDistortionOversampling(getDistortionOversampling());
 
         return state;
 }
@@ -324,6 +335,7 @@ void GeonkickApi::getOscillatorState(GeonkickApi::Layer layer,
         points = oscillatorEvelopePoints(index, GeonkickApi::EnvelopeType::FilterCutOff);
         state->setOscillatorEnvelopePoints(index, points, GeonkickApi::EnvelopeType::FilterCutOff);
         state->setOscillatorAsFm(index, isOscillatorAsFm(index));
+        state->setOscillatorBandLimited(index, isOscillatorBandLimited(index));
         currentLayer = temp;
 }
 
@@ -359,6 +371,7 @@ void GeonkickApi::setOscillatorState(GeonkickApi::Layer layer,
         setOscillatorEvelopePoints(osc, EnvelopeType::FilterCutOff,
                                    state->oscillatorEnvelopePoints(osc, EnvelopeType::FilterCutOff));
         setOscillatorAsFm(osc, state->isOscillatorAsFm(osc));
+        setOscillatorBandLimited(osc, state->isOscillatorBandLimited(osc));
 
         currentLayer = temp;
 }
@@ -700,6 +713,22 @@ bool GeonkickApi::isOscillatorAsFm(int oscillatorIndex) const
         return fm;
 }
 
+void GeonkickApi::setOscillatorBandLimited(int oscillatorIndex, bool b)
+{
+        geonkick_osc_set_band_limited(geonkickApi,
+                                      getOscIndex(oscillatorIndex),
+                                      b);
+}
+
+bool GeonkickApi::isOscillatorBandLimited(int oscillatorIndex) const
+{
+        bool bandLimited = false;
+        geonkick_osc_is_band_limited(geonkickApi,
+                                     getOscIndex(oscillatorIndex),
+                                     &bandLimited);
+        return bandLimited;
+}
+
 void GeonkickApi::enableOscillator(int oscillatorIndex, bool enable)
 {
         if (enable)
@@ -883,6 +912,23 @@ int GeonkickApi::getSampleRate() const
         return sampleRate;
 }
 
+void GeonkickApi::setSampleRate(int rate)
+{
+        geonkick_set_sample_rate(geonkickApi, rate);
+}
+
+bool GeonkickApi::setSynthesisThreads(size_t number)
+{
+        return geonkick_set_synthesis_threads(geonkickApi, number) == GEONKICK_OK;
+}
+
+size_t GeonkickApi::synthesisThreads() const
+{
+        size_t number = 0;
+        geonkick_get_synthesis_threads(geonkickApi, &number);
+        return number;
+}
+
 // This function is called only from the audio thread.
 void GeonkickApi::setKeyPressed(bool b, int note, int velocity)
 {
@@ -902,6 +948,41 @@ gkick_real GeonkickApi::getAudioFrame(int channel) const
         return val;
 }
 
+/**
+ * Queues the note event for the block. The events vector must not
+ * grow in the audio thread, when it is full the frames before
+ * the event are rendered with the queued events.
+ *
+ * This function is called only from the audio thread.
+ */
+void GeonkickApi::addNoteEvent(float **channels,
+                               size_t nChannels,
+                               size_t nFrames,
+                               const gkick_note_event &event)
+{
+        if (noteEvents.size() == noteEvents.capacity()) {
+                auto end = std::min(std::max(event.offset, renderedFrames), nFrames);
+                geonkick_render_block(geonkickApi, channels, nChannels,
+                                      renderedFrames, end - renderedFrames,
+                                      noteEvents.data(), noteEvents.size());
+                noteEvents.clear();
+                renderedFrames = end;
+        }
+        noteEvents.push_back(event);
+}
+
+// This function is called only from the audio thread.
+void GeonkickApi::renderBlock(float **channels,
+                              size_t nChannels,
+                              size_t nFrames)
+{
+        geonkick_render_block(geonkickApi, channels, nChannels,
+                              renderedFrames, nFrames - renderedFrames,
+                              noteEvents.data(), noteEvents.size());
+        noteEvents.clear();
+        renderedFrames = 0;
+}
+
 void GeonkickApi::enableCompressor(bool enable)
 {
         geonkick_compressor_enable(geonkickApi, enable);
@@ -1034,6 +1115,18 @@ double GeonkickApi::getDistortionDrive(void) const
         return drive;
 }
 
+void GeonkickApi::setDistortionOversampling(int factor)
+{
+        geonkick_distortion_set_oversampling(geonkickApi, factor);
+}
+
+int GeonkickApi::getDistortionOversampling() const
+{
+        int factor = 1;
+        geonkick_distortion_get_oversampling(geonkickApi, &factor);
+        return factor;
+}
+
 void GeonkickApi::registerCallbacks(bool b)
 {
         if (b) {
@@ -1209,6 +1302,36 @@ int GeonkickApi::getPercussionChannel(int index) const
         return channel;
 }
 
+bool GeonkickApi::setPercussionPolyphony(int index, size_t polyphony)
+{
+        auto res = geonkick_set_percussion_polyphony(geonkickApi,
+                                                     index,
+                                                     polyphony);
+        return res == GEONKICK_OK;
+}
+
+size_t GeonkickApi::getPercussionPolyphony(int index) const
+{
+        size_t polyphony = 1;
+        geonkick_get_percussion_polyphony(geonkickApi, index, &polyphony);
+        return polyphony;
+}
+
+bool GeonkickApi::setPercussionVoiceStealing(int index, VoiceStealing stealing)
+{
+        auto res = geonkick_set_percussion_voice_stealing(geonkickApi,
+                                                          index,
+                                                          static_cast<enum geonkick_voice_stealing>(stealing));
+        return res == GEONKICK_OK;
+}
+
+GeonkickApi::VoiceStealing GeonkickApi::getPercussionVoiceStealing(int index) const
+{
+        enum geonkick_voice_stealing stealing = GEONKICK_VOICE_STEALING_OLDEST;
+        geonkick_get_percussion_voice_stealing(geonkickApi, index, &stealing);
+        return static_cast<VoiceStealing>(stealing);
+}
+
 bool GeonkickApi::setPercussionName(int index, const std::string &name)
 {
         auto res = geonkick_set_percussion_name(geonkickApi,
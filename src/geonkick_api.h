@@ -73,6 +73,11 @@ class GeonkickApi {
           BandPass = GEONKICK_FILTER_BAND_PASS
   };
 
+  enum class VoiceStealing:int {
+          Oldest   = GEONKICK_VOICE_STEALING_OLDEST,
+          Quietest = GEONKICK_VOICE_STEALING_QUIETEST
+  };
+
   GeonkickApi();
   ~GeonkickApi();
   size_t numberOfChannels() const;
@@ -113,6 +118,8 @@ class GeonkickApi {
                               double frequency);
   void setOscillatorAsFm(int oscillatorIndex, bool b);
   bool isOscillatorAsFm(int oscillatorIndex) const;
+  void setOscillatorBandLimited(int oscillatorIndex, bool b);
+  bool isOscillatorBandLimited(int oscillatorIndex) const;
   double oscillatorAmplitude(int oscillatorIndex) const;
   double oscillatorFrequency(int oscillatorIndex) const;
   void addKickEnvelopePoint(EnvelopeType envelope,
@@ -151,12 +158,24 @@ class GeonkickApi {
                               double amplitude);
   double limiterValue() const;
   int getSampleRate() const;
+  void setSampleRate(int rate);
+  bool setSynthesisThreads(size_t number);
+  size_t synthesisThreads() const;
   static std::unique_ptr<KitState> getDefaultKitState();
   static std::shared_ptr<PercussionState> getDefaultPercussionState();
   // This function is called only from the audio thread.
   gkick_real getAudioFrame(int channel) const;
   // This function is called only from the audio thread.
   void setKeyPressed(bool b, int note, int velocity);
+  // This function is called only from the audio thread.
+  void addNoteEvent(float **channels,
+                    size_t nChannels,
+                    size_t nFrames,
+                    const gkick_note_event &event);
+  // This function is called only from the audio thread.
+  void renderBlock(float **channels,
+                   size_t nChannels,
+                   size_t nFrames);
   std::shared_ptr<PercussionState> getPercussionState(size_t id) const;
   std::shared_ptr<PercussionState> getPercussionState() const;
   bool isCompressorEnabled() const;
@@ -170,6 +189,7 @@ class GeonkickApi {
   double getDistortionInLimiter() const;
   double getDistortionVolume() const;
   double getDistortionDrive() const;
+  int getDistortionOversampling() const;
   bool isJackEnabled() const;
   void setStandalone(bool b);
   bool isStandalone() const;
@@ -206,6 +226,7 @@ class GeonkickApi {
   void setDistortionVolume(double volume);
   void setDistortionInLimiter(double limit);
   void setDistortionDrive(double drive);
+  void setDistortionOversampling(int factor);
   std::vector<gkick_real> getKickBuffer() const;
   void triggerSynthesis();
   void setLayer(Layer layer);
@@ -233,6 +254,10 @@ class GeonkickApi {
   int percussionsReferenceKey() const;
   bool setPercussionChannel(int index, size_t channel);
   int getPercussionChannel(int index) const;
+  bool setPercussionPolyphony(int index, size_t polyphony);
+  size_t getPercussionPolyphony(int index) const;
+  bool setPercussionVoiceStealing(int index, VoiceStealing stealing);
+  VoiceStealing getPercussionVoiceStealing(int index) const;
   bool setPercussionName(int index, const std::string &name);
   std::string getPercussionName(int index) const;
   void copyToClipboard();
@@ -316,6 +341,8 @@ private:
   std::unordered_map<std::string, std::filesystem::path> workingPaths;
   std::unordered_map<std::string, std::string> apiSettings;
   std::vector<int> percussionIdList;
+  std::vector<gkick_note_event> noteEvents;
+  size_t renderedFrames;
 };
 
 #endif // GEONKICK_API_H
@@ -158,6 +158,47 @@ void KitModel::decreasePercussionChannel(int index)
                 action modelUpdated();
 }
 
+void KitModel::increasePercussionPolyphony(int index)
+{
+        auto id = getPercussionId(index);
+        if (id < 0)
+                return;
+
+        auto polyphony = geonkickApi->getPercussionPolyphony(id);
+        if (++polyphony > GEONKICK_MAX_POLYPHONY)
+                polyphony = 1;
+        if (geonkickApi->setPercussionPolyphony(id, polyphony))
+                action modelUpdated();
+}
+
+void KitModel::decreasePercussionPolyphony(int index)
+{
+        auto id = getPercussionId(index);
+        if (id < 0)
+                return;
+
+        auto polyphony = geonkickApi->getPercussionPolyphony(id);
+        if (polyphony < 2)
+                polyphony = GEONKICK_MAX_POLYPHONY;
+        else
+                polyphony--;
+        if (geonkickApi->setPercussionPolyphony(id, polyphony))
+                action modelUpdated();
+}
+
+void KitModel::togglePercussionVoiceStealing(int index)
+{
+        auto id = getPercussionId(index);
+        if (id < 0)
+                return;
+
+        auto stealing = GeonkickApi::VoiceStealing::Quietest;
+        if (percussionStealsQuietest(index))
+                stealing = GeonkickApi::VoiceStealing::Oldest;
+        if (geonkickApi->setPercussionVoiceStealing(id, stealing))
+                action modelUpdated();
+}
+
 void KitModel::moveSelectedPercussion(bool down)
 {
         if (geonkickApi->moveOrdrepedPercussionId(geonkickApi->currentPercussion(), down ? 1 : -1))
@@ -226,6 +267,17 @@ int KitModel::percussionChannel(int index) const
         return geonkickApi->getPercussionChannel(getPercussionId(index));
 }
 
+size_t KitModel::percussionPolyphony(int index) const
+{
+        return geonkickApi->getPercussionPolyphony(getPercussionId(index));
+}
+
+bool KitModel::percussionStealsQuietest(int index) const
+{
+        return geonkickApi->getPercussionVoiceStealing(getPercussionId(index))
+                == GeonkickApi::VoiceStealing::Quietest;
+}
+
 bool KitModel::canCopy() const
 {
         auto n = geonkickApi->ordredPercussionIds().size();
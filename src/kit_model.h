@@ -41,6 +41,9 @@ class KitModel {
         void removePercussion(int index);
         void increasePercussionChannel(int index);
         void decreasePercussionChannel(int index);
+        void increasePercussionPolyphony(int index);
+        void decreasePercussionPolyphony(int index);
+        void togglePercussionVoiceStealing(int index);
         int percussionKeyIndex(int index) const;
         void moveSelectedPercussion(bool down = true);
         void setPercussionKey(int index, int keyIndex);
@@ -50,6 +53,8 @@ class KitModel {
         void setPercussionName(int index, const std::string &name);
         std::string percussionName(int index) const;
         int percussionChannel(int index) const;
+        size_t percussionPolyphony(int index) const;
+        bool percussionStealsQuietest(int index) const;
         bool canCopy() const;
         bool canRemove() const;
         std::filesystem::path workingPath(const std::string &key) const;
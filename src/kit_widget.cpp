@@ -41,11 +41,13 @@ KitWidget::KitWidget(GeonkickWidget *parent, KitModel *model)
         , kitModel{model}
 	, keyWidth{30}
 	, channelWidth{keyWidth}
+        , polyphonyWidth{50}
+        , voiceStealingWidth{60}
 	, percussionHeight{20}
         , percussionNameWidth{100}
         , percussionWidth{percussionNameWidth
                           + static_cast<decltype(keyWidth)>(kitModel->keysNumber()) * keyWidth
-                          + channelWidth}
+                          + channelWidth + polyphonyWidth + voiceStealingWidth}
 	, editPercussion{nullptr}
 	, editedLineIndex{-1}
         , addButton{nullptr}
@@ -118,6 +120,11 @@ void KitWidget::drawKeys(RkPainter &painter)
                 painter.drawText(txtRect, kitModel->keyName(i));
                 x += keyWidth;
         }
+
+        x += channelWidth;
+        painter.drawText(RkRect(x, 10, polyphonyWidth, painter.font().size()), "Voices");
+        x += polyphonyWidth;
+        painter.drawText(RkRect(x, 10, voiceStealingWidth, painter.font().size()), "Steal");
 }
 
 void KitWidget::drawPercussions(RkPainter &painter)
@@ -151,10 +158,18 @@ void KitWidget::drawPercussions(RkPainter &painter)
                                  std::string(kitModel->percussionName(i)),
                                  Rk::Alignment::AlignLeft);
                 auto channel = kitModel->percussionChannel(i);
-		painter.drawText(RkRect(percussionWidth - channelWidth,
+		painter.drawText(RkRect(percussionWidth - voiceStealingWidth - polyphonyWidth - channelWidth,
                                         y, channelWidth,
                                         percussionHeight),
 				 "#" + std::to_string(channel));
+		painter.drawText(RkRect(percussionWidth - voiceStealingWidth - polyphonyWidth,
+                                        y, polyphonyWidth,
+                                        percussionHeight),
+				 std::to_string(kitModel->percussionPolyphony(i)));
+		painter.drawText(RkRect(percussionWidth - voiceStealingWidth,
+                                        y, voiceStealingWidth,
+                                        percussionHeight),
+				 kitModel->percussionStealsQuietest(i) ? "Quietest" : "Oldest");
 
                 int x = rect.right() + 5;
                 if (kitModel->canRemove()) {
@@ -205,16 +220,29 @@ void KitWidget::mouseButtonPressEvent(const std::shared_ptr<RkMouseEvent> &event
         updatePercussionName();
 	auto index = getLine(event->x(), event->y());
         if (validPercussionIndex(index)) {
+                int polyphonyX = percussionWidth - voiceStealingWidth - polyphonyWidth;
+                int channelX = polyphonyX - channelWidth;
 		if (event->x() < percussionNameWidth) {
                         kitModel->selectPercussion(index);
-                } else if (event->x() > (percussionWidth - channelWidth)
-                           && event->x() < percussionWidth) {
+                } else if (event->x() > channelX && event->x() < polyphonyX) {
                         if(event->button() == RkMouseEvent::ButtonType::Left
                            || event->button() == RkMouseEvent::ButtonType::WheelUp) {
                                 kitModel->increasePercussionChannel(index);
                         } else if (event->button() == RkMouseEvent::ButtonType::WheelDown) {
                                 kitModel->decreasePercussionChannel(index);
                         }
+                } else if (event->x() > polyphonyX
+                           && event->x() < percussionWidth - voiceStealingWidth) {
+                        if(event->button() == RkMouseEvent::ButtonType::Left
+                           || event->button() == RkMouseEvent::ButtonType::WheelUp) {
+                                kitModel->increasePercussionPolyphony(index);
+                        } else if (event->button() == RkMouseEvent::ButtonType::WheelDown) {
+                                kitModel->decreasePercussionPolyphony(index);
+                        }
+                } else if (event->x() > percussionWidth - voiceStealingWidth
+                           && event->x() < percussionWidth) {
+                        if (event->button() == RkMouseEvent::ButtonType::Left)
+                                kitModel->togglePercussionVoiceStealing(index);
 		} else if ((event->x() > percussionWidth + 5)
                            && (event->x() < percussionWidth + 5 + 16)) {
                         if (kitModel->canRemove())
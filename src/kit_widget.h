@@ -66,6 +66,8 @@ class KitWidget: public GeonkickWidget
         KitModel *kitModel;
 	int keyWidth;
 	int channelWidth;
+        int polyphonyWidth;
+        int voiceStealingWidth;
 	int percussionHeight;
         int percussionNameWidth;
         int percussionWidth;
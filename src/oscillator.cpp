@@ -44,6 +44,16 @@ bool Oscillator::isFm() const
         return geonkickApi->isOscillatorAsFm(index());
 }
 
+void Oscillator::setBandLimited(bool b)
+{
+        geonkickApi->setOscillatorBandLimited(index(), b);
+}
+
+bool Oscillator::isBandLimited() const
+{
+        return geonkickApi->isOscillatorBandLimited(index());
+}
+
 void Oscillator::setFunction(FunctionType func)
 {
         geonkickApi->setOscillatorFunction(index(), static_cast<GeonkickApi::FunctionType>(func));
@@ -52,6 +52,8 @@ class Oscillator
   void enable(bool b);
   void setAsFm(bool b);
   bool isFm() const;
+  void setBandLimited(bool b);
+  bool isBandLimited() const;
   void setFunction(FunctionType func);
   void setPhase(gkick_real phase);
   gkick_real getPhase() const;
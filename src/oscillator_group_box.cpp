@@ -61,6 +61,8 @@ RK_DECLARE_IMAGE_RC(noise_type_white_active);
 RK_DECLARE_IMAGE_RC(noise_type_brownian);
 RK_DECLARE_IMAGE_RC(noise_type_brownian_active);
 RK_DECLARE_IMAGE_RC(knob_bk_image);
+RK_DECLARE_IMAGE_RC(checkbox_checked_10x10);
+RK_DECLARE_IMAGE_RC(checkbox_unchecked_10x10);
 
 OscillatorGroupBox::OscillatorGroupBox(GeonkickWidget *parent, Oscillator *osc)
           : GeonkickGroupBox{parent}
@@ -75,6 +77,7 @@ OscillatorGroupBox::OscillatorGroupBox(GeonkickWidget *parent, Oscillator *osc)
            , sampleButton{nullptr}
            , sampleBrowseButton{nullptr}
            , phaseSlider{nullptr}
+           , bandLimitedCheckbox{nullptr}
            , noiseWhiteButton{nullptr}
            , noiseBrownianButton{nullptr}
            , envelopeAmplitudeKnob{nullptr}
@@ -192,11 +195,28 @@ void OscillatorGroupBox::createWaveFunctionGroupBox()
         phaseLabel->show();
 
         phaseSlider = new GeonkickSlider(waveFunctionHBox);
-        phaseSlider->setFixedSize(150, 8);
+        phaseSlider->setFixedSize(90, 8);
         phaseSlider->onSetValue(50);
         phaseSlider->setPosition(phaseLabel->x() + phaseLabel->width() + 5, phaseLabel->y() + 1);
         phaseSlider->show();
         RK_ACT_BIND(phaseSlider, valueUpdated, RK_ACT_ARGS(int value), this, setOscillatorPhase(value));
+
+        bandLimitedCheckbox = new GeonkickButton(waveFunctionHBox);
+        bandLimitedCheckbox->setCheckable(true);
+        bandLimitedCheckbox->setBackgroundColor(waveFunctionHBox->background());
+        bandLimitedCheckbox->setFixedSize(10, 10);
+        bandLimitedCheckbox->setPosition(phaseSlider->x() + phaseSlider->width() + 7, phaseLabel->y() - 1);
+        bandLimitedCheckbox->setPressedImage(RkImage(10, 10, rk_checkbox_checked_10x10_png));
+        bandLimitedCheckbox->setUnpressedImage(RkImage(10, 10, rk_checkbox_unchecked_10x10_png));
+        RK_ACT_BIND(bandLimitedCheckbox, toggled, RK_ACT_ARGS(bool b), oscillator, setBandLimited(b));
+
+        auto bandLimitedLabel = new RkLabel(waveFunctionHBox, "Anti-alias");
+        bandLimitedLabel->setFixedSize(56, 10);
+        bandLimitedLabel->setTextColor({210, 226, 226, 160});
+        bandLimitedLabel->setBackgroundColor(waveFunctionHBox->background());
+        bandLimitedLabel->setPosition(bandLimitedCheckbox->x() + bandLimitedCheckbox->width() + 3,
+                                      bandLimitedCheckbox->y());
+        bandLimitedLabel->show();
 }
 
 void OscillatorGroupBox::createEvelopeGroupBox()
@@ -400,6 +420,7 @@ void OscillatorGroupBox::updateGui()
                 sawtoothButton->setPressed(oscillator->function() == Oscillator::FunctionType::Sawtooth);
                 sampleButton->setPressed(oscillator->function() == Oscillator::FunctionType::Sample);
                 phaseSlider->onSetValue(oscillator->getPhase());
+                bandLimitedCheckbox->setPressed(oscillator->isBandLimited());
         }
 
         envelopeAmplitudeKnob->setCurrentValue(oscillator->amplitude());
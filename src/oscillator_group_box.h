@@ -73,6 +73,7 @@ class OscillatorGroupBox: public GeonkickGroupBox
         GeonkickButton *sampleButton;
         GeonkickButton *sampleBrowseButton;
         GeonkickSlider *phaseSlider;
+        GeonkickButton *bandLimitedCheckbox;
         GeonkickSlider *seedSlider;
         GeonkickButton *noiseWhiteButton;
         GeonkickButton *noiseBrownianButton;
@@ -32,6 +32,8 @@ PercussionState::PercussionState()
         , kickName{"Default"}
         , playingKey{-1}
         , outputChannel{0}
+        , voicesPolyphony{GEONKICK_DEFAULT_POLYPHONY}
+        , voiceStealing{GeonkickApi::VoiceStealing::Oldest}
         , kickEnabled{true}
         , limiterValue{0}
         , kickLength{50}
@@ -41,7 +43,7 @@ PercussionState::PercussionState()
         , kickFilterQFactor{1.0}
         , kickFilterType{GeonkickApi::FilterType::LowPass}
         , compressor{false, 0, 0, 0, 0, 0, 0}
-        , distortion{false, 1.0, 1.0, 1.0}
+        , distortion{false, 1.0, 1.0, 1.0, 1}
         , layers{false, false, false}
         , layersAmplitude{1.0, 1.0, 1.0}
         , currentLayer{GeonkickApi::Layer::Layer1}
@@ -159,6 +161,26 @@ size_t PercussionState::getChannel() const
         return outputChannel;
 }
 
+void PercussionState::setPolyphony(size_t polyphony)
+{
+        voicesPolyphony = polyphony;
+}
+
+size_t PercussionState::getPolyphony() const
+{
+        return voicesPolyphony;
+}
+
+void PercussionState::setVoiceStealing(GeonkickApi::VoiceStealing stealing)
+{
+        voiceStealing = stealing;
+}
+
+GeonkickApi::VoiceStealing PercussionState::getVoiceStealing() const
+{
+        return voiceStealing;
+}
+
 bool PercussionState::isEnabled() const
 {
         return kickEnabled;
@@ -210,6 +232,10 @@ void PercussionState::parseKickObject(const rapidjson::Value &kick)
                         setId(m.value.GetInt());
                 if (m.name == "channel" && m.value.IsInt())
                         setChannel(m.value.GetInt());
+                if (m.name == "polyphony" && m.value.IsInt())
+                        setPolyphony(m.value.GetInt());
+                if (m.name == "voice_stealing" && m.value.IsInt())
+                        setVoiceStealing(static_cast<GeonkickApi::VoiceStealing>(m.value.GetInt()));
                 if (m.name == "playing_key" && m.value.IsInt())
                         setPlayingKey(m.value.GetInt());
                 if (m.name == "limiter" && m.value.IsDouble())
@@ -299,6 +325,8 @@ void PercussionState::parseKickObject(const rapidjson::Value &kick)
                                         setDistortionVolume(el.value.GetDouble());
                                 if (el.name == "drive" && el.value.IsDouble())
                                         setDistortionDrive(el.value.GetDouble());
+                                if (el.name == "oversampling" && el.value.IsInt())
+                                        setDistortionOversampling(el.value.GetInt());
 				if (el.name == "drive_env" && el.value.IsArray())
 					setKickEnvelopePoints(GeonkickApi::EnvelopeType::DistortionDrive,
 							      parseEnvelopeArray(el.value));
@@ -317,6 +345,8 @@ void PercussionState::parseOscillatorObject(int index,  const rapidjson::Value &
                         setOscillatorEnabled(index, m.value.GetBool());
                 if (m.name == "is_fm" && m.value.IsBool())
                         setOscillatorAsFm(index, m.value.GetBool());
+                if (m.name == "band_limited" && m.value.IsBool())
+                        setOscillatorBandLimited(index, m.value.GetBool());
                 if (m.name == "sample" && m.value.IsString())
                         setOscillatorSample(index, fromBase64F(std::string(m.value.GetString())));
                 if (m.name == "function" && m.value.IsInt())
@@ -587,6 +617,21 @@ void PercussionState::setOscillatorAsFm(int index, bool b)
                oscillator->isFm = b;
 }
 
+bool PercussionState::isOscillatorBandLimited(int index) const
+{
+        auto oscillator = getOscillator(index);
+        if (oscillator)
+                return oscillator->isBandLimited;
+        return false;
+}
+
+void PercussionState::setOscillatorBandLimited(int index, bool b)
+{
+        auto oscillator = getOscillator(index);
+        if (oscillator)
+               oscillator->isBandLimited = b;
+}
+
 bool PercussionState::isOscillatorEnabled(int index) const
 {
         auto oscillator = getOscillator(index);
@@ -797,6 +842,16 @@ double PercussionState::getDistortionDrive() const
         return distortion.drive;
 }
 
+void PercussionState::setDistortionOversampling(int factor)
+{
+        distortion.oversampling = factor;
+}
+
+int PercussionState::getDistortionOversampling() const
+{
+        return distortion.oversampling;
+}
+
 std::string PercussionState::toJson() const
 {
         std::ostringstream jsonStream;
@@ -813,6 +868,7 @@ void PercussionState::oscJson(std::ostringstream &jsonStream) const
                 jsonStream << "\"osc" << val.first << "\": {" << std::endl;
                 jsonStream << "\"enabled\": " << (val.second->isEnabled ? "true" : "false") << ", " << std::endl;
                 jsonStream << "\"is_fm\": " << (val.second->isFm ? "true" : "false") << ", " << std::endl;
+                jsonStream << "\"band_limited\": " << (val.second->isBandLimited ? "true" : "false") << ", " << std::endl;
                 if (val.second->function == GeonkickApi::FunctionType::Sample && !val.second->sample.empty())
                         jsonStream <<  "\"sample\": \"" << toBase64F(val.second->sample) << "\"," << std::endl;
                 jsonStream <<  "\"function\": " << static_cast<int>(val.second->function) << "," << std::endl;
@@ -880,6 +936,8 @@ void PercussionState::kickJson(std::ostringstream &jsonStream) const
         jsonStream << "\"PercussionAppVersion\": " << GEONKICK_VERSION << "," << std::endl;
 	jsonStream << "\"id\": " << getId() << "," << std::endl;
         jsonStream << "\"channel\": " << getChannel() << "," << std::endl;
+        jsonStream << "\"polyphony\": " << getPolyphony() << "," << std::endl;
+        jsonStream << "\"voice_stealing\": " << static_cast<int>(getVoiceStealing()) << "," << std::endl;
         jsonStream << "\"name\": \"" << getName() << "\"," << std::endl;
         jsonStream << "\"playing_key\": " << static_cast<int>(getPlayingKey()) << "," << std::endl;
         jsonStream << "\"layers\": [";
@@ -970,6 +1028,7 @@ void PercussionState::kickJson(std::ostringstream &jsonStream) const
                    << getDistortionVolume()  << ", " << std::endl;
         jsonStream << "\"drive\": " << std::fixed << std::setprecision(5)
                    << getDistortionDrive() << ", " << std::endl;
+        jsonStream << "\"oversampling\": " << getDistortionOversampling() << ", " << std::endl;
 	jsonStream << "\"drive_env\": [" << std::endl;
 	points = getKickEnvelopePoints(GeonkickApi::EnvelopeType::DistortionDrive);
         first = true;
@@ -43,6 +43,10 @@ class PercussionState
         void setId(size_t id);
         void setChannel(size_t channel);
         size_t getChannel() const;
+        void setPolyphony(size_t polyphony);
+        size_t getPolyphony() const;
+        void setVoiceStealing(GeonkickApi::VoiceStealing stealing);
+        GeonkickApi::VoiceStealing getVoiceStealing() const;
         std::string getName() const;
         void setName(const std::string &name);
         char getPlayingKey() const;
@@ -81,6 +85,8 @@ class PercussionState
                                          GeonkickApi::EnvelopeType envelope);
         bool isOscillatorAsFm(int index) const;
         void setOscillatorAsFm(int index, bool b);
+        bool isOscillatorBandLimited(int index) const;
+        void setOscillatorBandLimited(int index, bool b);
         bool isOscillatorEnabled(int index) const;
         GeonkickApi::FunctionType oscillatorFunction(int index) const;
         double oscillatorAmplitue(int index) const;
@@ -114,9 +120,11 @@ class PercussionState
         void setDistortionVolume(double volume);
         void setDistortionInLimiter(double limit);
         void setDistortionDrive(double drive);
+        void setDistortionOversampling(int factor);
         double getDistortionInLimiter() const;
         double getDistortionVolume() const;
         double getDistortionDrive() const;
+        int getDistortionOversampling() const;
         std::string toJson() const;
         void setLayerEnabled(GeonkickApi::Layer layer, bool b);
         bool isLayerEnabled(GeonkickApi::Layer layer) const;
@@ -143,6 +151,7 @@ private:
               : type{GeonkickApi::OscillatorType::Oscillator1}
                 , isEnabled{false}
                 , isFm{false}
+                , isBandLimited{false}
                 , function{GeonkickApi::FunctionType::Sine}
                 , phase{0}
                 , seed{0}
@@ -156,6 +165,7 @@ private:
                 std::vector<float> sample;
                 bool isEnabled;
                 bool isFm;
+                bool isBandLimited;
                 GeonkickApi::FunctionType function;
                 double phase;
                 int seed;
@@ -187,6 +197,7 @@ private:
                 double in_limiter;
                 double volume;
                 double drive;
+                int oversampling;
         };
 
         int appVersion;
@@ -194,6 +205,8 @@ private:
         std::string kickName;
         char playingKey;
         size_t outputChannel;
+        size_t voicesPolyphony;
+        GeonkickApi::VoiceStealing voiceStealing;
         bool kickEnabled;
 
         double limiterValue;
@@ -26,6 +26,8 @@
 
 #include <RkMain.h>
 
+#include <thread>
+
 int main(int argc, char *argv[])
 {
         RkMain app(argc, argv);
@@ -43,6 +45,11 @@ int main(int argc, char *argv[])
                 exit(1);
         }
 
+        // The standalone is the only instance, it can use all the cores.
+        auto cores = std::thread::hardware_concurrency();
+        if (cores > 0)
+                api->setSynthesisThreads(std::min(cores, static_cast<unsigned int>(GEONKICK_MAX_PERCUSSIONS)));
+
         auto window = new MainWindow(&app, api, preset);
         if (!window->init()) {
                 GEONKICK_LOG_ERROR("can't init main window");